@@ -0,0 +1,102 @@
+/*
+ * Host round trip and size/speed comparison of JSON and MessagePack for the state API
+ * (same ArduinoJson as the firmware, so the encoding is the one sent by POST /json, WebSockets and UDP)
+ * Run with: pio test -e native -f test_msgpack -v   (-v shows the measurements)
+ */
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <string>
+#include "../../wled00/src/dependencies/json/ArduinoJson-v6.h"
+
+#define DOC_SIZE 8192
+#define ROUNDS   2000
+
+//a /json/state response with 3 segments, as served by the firmware
+static const char stateJson[] =
+  "{\"on\":true,\"bri\":128,\"transition\":7,\"ps\":-1,\"pl\":-1,"
+  "\"nl\":{\"on\":false,\"dur\":60,\"mode\":1,\"tbri\":0,\"rem\":-1},"
+  "\"udpn\":{\"send\":false,\"recv\":true},\"lor\":0,\"mainseg\":0,\"seg\":["
+  "{\"id\":0,\"start\":0,\"stop\":100,\"len\":100,\"grp\":1,\"spc\":0,\"of\":0,\"on\":true,\"frz\":false,\"bri\":255,\"cct\":127,"
+  "\"col\":[[255,160,0],[0,0,0],[0,0,0]],\"fx\":0,\"sx\":128,\"ix\":128,\"pal\":0,\"sel\":true,\"rev\":false,\"mi\":false},"
+  "{\"id\":1,\"start\":100,\"stop\":200,\"len\":100,\"grp\":1,\"spc\":0,\"of\":0,\"on\":true,\"frz\":false,\"bri\":255,\"cct\":127,"
+  "\"n\":\"Shelf\",\"col\":[[0,255,200],[0,0,0],[0,0,0]],\"fx\":9,\"sx\":200,\"ix\":64,\"pal\":11,\"sel\":false,\"rev\":true,\"mi\":false},"
+  "{\"id\":2,\"start\":200,\"stop\":300,\"len\":100,\"grp\":2,\"spc\":1,\"of\":0,\"on\":false,\"frz\":false,\"bri\":80,\"cct\":0,"
+  "\"col\":[[255,255,255],[10,20,30],[0,0,0]],\"fx\":65,\"sx\":100,\"ix\":250,\"pal\":48,\"sel\":false,\"rev\":false,\"mi\":true}]}";
+
+//a typical command (color and effect of one segment)
+static const char commandJson[] = "{\"on\":true,\"bri\":200,\"seg\":[{\"id\":1,\"col\":[[255,0,0]],\"fx\":38,\"sx\":150}]}";
+
+static std::string toMsgPack(const char* json)
+{
+  DynamicJsonDocument doc(DOC_SIZE);
+  TEST_ASSERT_FALSE(deserializeJson(doc, json));
+  std::string out(measureMsgPack(doc), '\0');
+  serializeMsgPack(doc, &out[0], out.size());
+  return out;
+}
+
+//MessagePack decodes to the same document as the JSON it was encoded from
+static void roundTrip(const char* json)
+{
+  std::string mp = toMsgPack(json);
+  DynamicJsonDocument doc(DOC_SIZE);
+  TEST_ASSERT_FALSE(deserializeMsgPack(doc, mp.data(), mp.size()));
+  std::string back;
+  serializeJson(doc, back);
+  TEST_ASSERT_EQUAL_STRING(json, back.c_str());
+  TEST_ASSERT_TRUE(mp.size() < strlen(json)); //the point of offering it
+}
+
+void test_roundtrip_state()
+{
+  roundTrip(stateJson);
+}
+
+void test_roundtrip_command()
+{
+  roundTrip(commandJson);
+}
+
+//the first byte is what IS_MSGPACK_MAP() in const.h tells JSON and MessagePack apart with
+void test_first_byte_is_map()
+{
+  uint8_t b = (uint8_t)toMsgPack(commandJson)[0];
+  TEST_ASSERT_TRUE((b & 0xF0) == 0x80 || b == 0xDE || b == 0xDF);
+  TEST_ASSERT_TRUE(commandJson[0] == '{');
+}
+
+template <typename F>
+static double usPerRound(F fn)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ROUNDS; i++) fn();
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / ROUNDS;
+}
+
+//sizes and parse/serialize times of both encodings, only reported (host timings do not transfer to the ESP)
+void test_benchmark_state()
+{
+  std::string mp = toMsgPack(stateJson);
+  DynamicJsonDocument doc(DOC_SIZE);
+  size_t sink = 0;
+  double jsonParse = usPerRound([&]() { deserializeJson(doc, stateJson); sink += doc.memoryUsage(); });
+  double jsonWrite = usPerRound([&]() { char out[2048]; sink += serializeJson(doc, out, sizeof(out)); });
+  double mpParse   = usPerRound([&]() { deserializeMsgPack(doc, mp.data(), mp.size()); sink += doc.memoryUsage(); });
+  double mpWrite   = usPerRound([&]() { char out[2048]; sink += serializeMsgPack(doc, out, sizeof(out)); });
+  char msg[200];
+  snprintf(msg, sizeof(msg), "state: JSON %u bytes, parse %.2f us, serialize %.2f us | MessagePack %u bytes, parse %.2f us, serialize %.2f us",
+    (unsigned)strlen(stateJson), jsonParse, jsonWrite, (unsigned)mp.size(), mpParse, mpWrite);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_TRUE(sink > 0);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_roundtrip_state);
+  RUN_TEST(test_roundtrip_command);
+  RUN_TEST(test_first_byte_is_map);
+  RUN_TEST(test_benchmark_state);
+  return UNITY_END();
+}
@@ -0,0 +1,79 @@
+//byte streams as sent by Adalight and TPM2 hosts, used by test_main.cpp
+#include <stdint.h>
+
+static const uint8_t cap_ada_4leds[] = {
+  0x76,0x0A,0x41,0x64,0x61,0x00,0x03,0x56,0xFF,0x00,0x00,0x00,0xFF,0x00,0x00,0x00,
+  0xFF,0x0A,0x14,0x1E,0x41,0x64,0x61,0x00,0x03,0x56,0x01,0x02,0x03,0x04,0x05,0x06,
+  0x07,0x08,0x09,0xFA,0xFB,0xFC,
+};
+
+static const uint8_t cap_ada_badcheck[] = {
+  0x41,0x64,0x61,0x00,0x03,0xA9,0x41,0x64,0x61,0x00,0x01,0x54,0x41,0x64,0x61,0x00,
+  0x00,0x00,
+};
+
+static const uint8_t cap_tpm2[] = {
+  0xC9,0xAA,0xC9,0xDA,0x00,0x09,0x09,0x08,0x07,0x06,0x05,0x04,0x03,0x02,0x01,0x36,
+  0xC9,0xDA,0x00,0x04,0x01,0x02,0x03,0x04,0x36,
+};
+
+static const uint8_t cap_ada_300leds[] = {
+  0x41,0x64,0x61,0x01,0x2B,0x7F,0x00,0x07,0x0E,0x15,0x1C,0x23,0x2A,0x31,0x38,0x3F,
+  0x46,0x4D,0x54,0x5B,0x62,0x69,0x70,0x77,0x7E,0x85,0x8C,0x93,0x9A,0xA1,0xA8,0xAF,
+  0xB6,0xBD,0xC4,0xCB,0xD2,0xD9,0xE0,0xE7,0xEE,0xF5,0xFC,0x03,0x0A,0x11,0x18,0x1F,
+  0x26,0x2D,0x34,0x3B,0x42,0x49,0x50,0x57,0x5E,0x65,0x6C,0x73,0x7A,0x81,0x88,0x8F,
+  0x96,0x9D,0xA4,0xAB,0xB2,0xB9,0xC0,0xC7,0xCE,0xD5,0xDC,0xE3,0xEA,0xF1,0xF8,0xFF,
+  0x06,0x0D,0x14,0x1B,0x22,0x29,0x30,0x37,0x3E,0x45,0x4C,0x53,0x5A,0x61,0x68,0x6F,
+  0x76,0x7D,0x84,0x8B,0x92,0x99,0xA0,0xA7,0xAE,0xB5,0xBC,0xC3,0xCA,0xD1,0xD8,0xDF,
+  0xE6,0xED,0xF4,0xFB,0x02,0x09,0x10,0x17,0x1E,0x25,0x2C,0x33,0x3A,0x41,0x48,0x4F,
+  0x56,0x5D,0x64,0x6B,0x72,0x79,0x80,0x87,0x8E,0x95,0x9C,0xA3,0xAA,0xB1,0xB8,0xBF,
+  0xC6,0xCD,0xD4,0xDB,0xE2,0xE9,0xF0,0xF7,0xFE,0x05,0x0C,0x13,0x1A,0x21,0x28,0x2F,
+  0x36,0x3D,0x44,0x4B,0x52,0x59,0x60,0x67,0x6E,0x75,0x7C,0x83,0x8A,0x91,0x98,0x9F,
+  0xA6,0xAD,0xB4,0xBB,0xC2,0xC9,0xD0,0xD7,0xDE,0xE5,0xEC,0xF3,0xFA,0x01,0x08,0x0F,
+  0x16,0x1D,0x24,0x2B,0x32,0x39,0x40,0x47,0x4E,0x55,0x5C,0x63,0x6A,0x71,0x78,0x7F,
+  0x86,0x8D,0x94,0x9B,0xA2,0xA9,0xB0,0xB7,0xBE,0xC5,0xCC,0xD3,0xDA,0xE1,0xE8,0xEF,
+  0xF6,0xFD,0x04,0x0B,0x12,0x19,0x20,0x27,0x2E,0x35,0x3C,0x43,0x4A,0x51,0x58,0x5F,
+  0x66,0x6D,0x74,0x7B,0x82,0x89,0x90,0x97,0x9E,0xA5,0xAC,0xB3,0xBA,0xC1,0xC8,0xCF,
+  0xD6,0xDD,0xE4,0xEB,0xF2,0xF9,0x00,0x07,0x0E,0x15,0x1C,0x23,0x2A,0x31,0x38,0x3F,
+  0x46,0x4D,0x54,0x5B,0x62,0x69,0x70,0x77,0x7E,0x85,0x8C,0x93,0x9A,0xA1,0xA8,0xAF,
+  0xB6,0xBD,0xC4,0xCB,0xD2,0xD9,0xE0,0xE7,0xEE,0xF5,0xFC,0x03,0x0A,0x11,0x18,0x1F,
+  0x26,0x2D,0x34,0x3B,0x42,0x49,0x50,0x57,0x5E,0x65,0x6C,0x73,0x7A,0x81,0x88,0x8F,
+  0x96,0x9D,0xA4,0xAB,0xB2,0xB9,0xC0,0xC7,0xCE,0xD5,0xDC,0xE3,0xEA,0xF1,0xF8,0xFF,
+  0x06,0x0D,0x14,0x1B,0x22,0x29,0x30,0x37,0x3E,0x45,0x4C,0x53,0x5A,0x61,0x68,0x6F,
+  0x76,0x7D,0x84,0x8B,0x92,0x99,0xA0,0xA7,0xAE,0xB5,0xBC,0xC3,0xCA,0xD1,0xD8,0xDF,
+  0xE6,0xED,0xF4,0xFB,0x02,0x09,0x10,0x17,0x1E,0x25,0x2C,0x33,0x3A,0x41,0x48,0x4F,
+  0x56,0x5D,0x64,0x6B,0x72,0x79,0x80,0x87,0x8E,0x95,0x9C,0xA3,0xAA,0xB1,0xB8,0xBF,
+  0xC6,0xCD,0xD4,0xDB,0xE2,0xE9,0xF0,0xF7,0xFE,0x05,0x0C,0x13,0x1A,0x21,0x28,0x2F,
+  0x36,0x3D,0x44,0x4B,0x52,0x59,0x60,0x67,0x6E,0x75,0x7C,0x83,0x8A,0x91,0x98,0x9F,
+  0xA6,0xAD,0xB4,0xBB,0xC2,0xC9,0xD0,0xD7,0xDE,0xE5,0xEC,0xF3,0xFA,0x01,0x08,0x0F,
+  0x16,0x1D,0x24,0x2B,0x32,0x39,0x40,0x47,0x4E,0x55,0x5C,0x63,0x6A,0x71,0x78,0x7F,
+  0x86,0x8D,0x94,0x9B,0xA2,0xA9,0xB0,0xB7,0xBE,0xC5,0xCC,0xD3,0xDA,0xE1,0xE8,0xEF,
+  0xF6,0xFD,0x04,0x0B,0x12,0x19,0x20,0x27,0x2E,0x35,0x3C,0x43,0x4A,0x51,0x58,0x5F,
+  0x66,0x6D,0x74,0x7B,0x82,0x89,0x90,0x97,0x9E,0xA5,0xAC,0xB3,0xBA,0xC1,0xC8,0xCF,
+  0xD6,0xDD,0xE4,0xEB,0xF2,0xF9,0x00,0x07,0x0E,0x15,0x1C,0x23,0x2A,0x31,0x38,0x3F,
+  0x46,0x4D,0x54,0x5B,0x62,0x69,0x70,0x77,0x7E,0x85,0x8C,0x93,0x9A,0xA1,0xA8,0xAF,
+  0xB6,0xBD,0xC4,0xCB,0xD2,0xD9,0xE0,0xE7,0xEE,0xF5,0xFC,0x03,0x0A,0x11,0x18,0x1F,
+  0x26,0x2D,0x34,0x3B,0x42,0x49,0x50,0x57,0x5E,0x65,0x6C,0x73,0x7A,0x81,0x88,0x8F,
+  0x96,0x9D,0xA4,0xAB,0xB2,0xB9,0xC0,0xC7,0xCE,0xD5,0xDC,0xE3,0xEA,0xF1,0xF8,0xFF,
+  0x06,0x0D,0x14,0x1B,0x22,0x29,0x30,0x37,0x3E,0x45,0x4C,0x53,0x5A,0x61,0x68,0x6F,
+  0x76,0x7D,0x84,0x8B,0x92,0x99,0xA0,0xA7,0xAE,0xB5,0xBC,0xC3,0xCA,0xD1,0xD8,0xDF,
+  0xE6,0xED,0xF4,0xFB,0x02,0x09,0x10,0x17,0x1E,0x25,0x2C,0x33,0x3A,0x41,0x48,0x4F,
+  0x56,0x5D,0x64,0x6B,0x72,0x79,0x80,0x87,0x8E,0x95,0x9C,0xA3,0xAA,0xB1,0xB8,0xBF,
+  0xC6,0xCD,0xD4,0xDB,0xE2,0xE9,0xF0,0xF7,0xFE,0x05,0x0C,0x13,0x1A,0x21,0x28,0x2F,
+  0x36,0x3D,0x44,0x4B,0x52,0x59,0x60,0x67,0x6E,0x75,0x7C,0x83,0x8A,0x91,0x98,0x9F,
+  0xA6,0xAD,0xB4,0xBB,0xC2,0xC9,0xD0,0xD7,0xDE,0xE5,0xEC,0xF3,0xFA,0x01,0x08,0x0F,
+  0x16,0x1D,0x24,0x2B,0x32,0x39,0x40,0x47,0x4E,0x55,0x5C,0x63,0x6A,0x71,0x78,0x7F,
+  0x86,0x8D,0x94,0x9B,0xA2,0xA9,0xB0,0xB7,0xBE,0xC5,0xCC,0xD3,0xDA,0xE1,0xE8,0xEF,
+  0xF6,0xFD,0x04,0x0B,0x12,0x19,0x20,0x27,0x2E,0x35,0x3C,0x43,0x4A,0x51,0x58,0x5F,
+  0x66,0x6D,0x74,0x7B,0x82,0x89,0x90,0x97,0x9E,0xA5,0xAC,0xB3,0xBA,0xC1,0xC8,0xCF,
+  0xD6,0xDD,0xE4,0xEB,0xF2,0xF9,0x00,0x07,0x0E,0x15,0x1C,0x23,0x2A,0x31,0x38,0x3F,
+  0x46,0x4D,0x54,0x5B,0x62,0x69,0x70,0x77,0x7E,0x85,0x8C,0x93,0x9A,0xA1,0xA8,0xAF,
+  0xB6,0xBD,0xC4,0xCB,0xD2,0xD9,0xE0,0xE7,0xEE,0xF5,0xFC,0x03,0x0A,0x11,0x18,0x1F,
+  0x26,0x2D,0x34,0x3B,0x42,0x49,0x50,0x57,0x5E,0x65,0x6C,0x73,0x7A,0x81,0x88,0x8F,
+  0x96,0x9D,0xA4,0xAB,0xB2,0xB9,0xC0,0xC7,0xCE,0xD5,0xDC,0xE3,0xEA,0xF1,0xF8,0xFF,
+  0x06,0x0D,0x14,0x1B,0x22,0x29,0x30,0x37,0x3E,0x45,0x4C,0x53,0x5A,0x61,0x68,0x6F,
+  0x76,0x7D,0x84,0x8B,0x92,0x99,0xA0,0xA7,0xAE,0xB5,0xBC,0xC3,0xCA,0xD1,0xD8,0xDF,
+  0xE6,0xED,0xF4,0xFB,0x02,0x09,0x10,0x17,0x1E,0x25,0x2C,0x33,0x3A,0x41,0x48,0x4F,
+  0x56,0x5D,0x64,0x6B,0x72,0x79,0x80,0x87,0x8E,0x95,
+};
+
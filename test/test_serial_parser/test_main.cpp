@@ -0,0 +1,119 @@
+/*
+ * Host test of the Adalight/TPM2 parser used by handleSerial()
+ * Run with: pio test -e native -f test_serial_parser
+ */
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "../../wled00/serial_parser.h"
+#include "captures.h"
+
+struct ParseResult {
+  std::vector<std::vector<uint8_t>> frames;
+  std::string commands;  //command bytes, in order
+  int pings = 0;
+};
+
+//feeds a capture like handleSerial() does: headers byte by byte, pixel data in blocks of up to block bytes
+//(block 0 passes everything that is left to the parser at once)
+static ParseResult feed(const uint8_t* data, size_t len, size_t block, uint32_t capacity)
+{
+  SerialFrameParser parser;
+  parser.setCapacity(capacity);
+  ParseResult r;
+  size_t pos = 0;
+  while (pos < len) {
+    uint8_t event;
+    size_t n = len - pos;
+    if (block && parser.dataLeft()) n = (n < block) ? n : block;
+    else if (block) n = 1;
+    size_t used = parser.parse(data + pos, n, event);
+    if (event == SerialFrameParser::SP_COMMAND) {
+      r.commands += (char)parser.command();
+      used++; //handleSerial() reads or discards it
+    }
+    if (event == SerialFrameParser::SP_FRAME) r.frames.emplace_back(parser.frame(), parser.frame() + parser.frameLeds()*3);
+    if (event == SerialFrameParser::SP_TPM2_PING) r.pings++;
+    TEST_ASSERT_TRUE(used > 0);
+    pos += used;
+  }
+  return r;
+}
+
+static void assertFrame(const std::vector<uint8_t>& frame, const uint8_t* expected, size_t len)
+{
+  TEST_ASSERT_EQUAL(len, frame.size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, frame.data(), len);
+}
+
+static const uint8_t frame1[] = {255,0,0, 0,255,0, 0,0,255, 10,20,30};
+static const uint8_t frame2[] = {1,2,3, 4,5,6, 7,8,9, 250,251,252};
+
+void test_adalight_frames()
+{
+  ParseResult r = feed(cap_ada_4leds, sizeof(cap_ada_4leds), 64, 300*3);
+  TEST_ASSERT_EQUAL(2, r.frames.size());
+  assertFrame(r.frames[0], frame1, sizeof(frame1));
+  assertFrame(r.frames[1], frame2, sizeof(frame2));
+  TEST_ASSERT_EQUAL_STRING("v\n", r.commands.c_str());
+}
+
+//the result must not depend on how the bytes are split up by the serial driver
+void test_block_sizes()
+{
+  const size_t blocks[] = {0, 1, 2, 5, 7, 128};
+  ParseResult ref = feed(cap_ada_300leds, sizeof(cap_ada_300leds), 0, 300*3);
+  for (size_t b : blocks) {
+    ParseResult r = feed(cap_ada_4leds, sizeof(cap_ada_4leds), b, 300*3);
+    TEST_ASSERT_EQUAL(2, r.frames.size());
+    assertFrame(r.frames[1], frame2, sizeof(frame2));
+    r = feed(cap_ada_300leds, sizeof(cap_ada_300leds), b, 300*3);
+    TEST_ASSERT_EQUAL(1, r.frames.size());
+    assertFrame(r.frames[0], ref.frames[0].data(), ref.frames[0].size());
+  }
+}
+
+void test_adalight_bad_checksum()
+{
+  const uint8_t expected[] = {'A','d','a', 0,0,0}; //header bytes inside pixel data are data
+  ParseResult r = feed(cap_ada_badcheck, sizeof(cap_ada_badcheck), 64, 300*3);
+  TEST_ASSERT_EQUAL(1, r.frames.size());
+  assertFrame(r.frames[0], expected, sizeof(expected));
+  TEST_ASSERT_EQUAL(0, r.commands.size());
+}
+
+void test_tpm2()
+{
+  const uint8_t expected1[] = {9,8,7,6,5,4,3,2,1};
+  const uint8_t expected2[] = {1,2,3}; //incomplete LED is dropped
+  ParseResult r = feed(cap_tpm2, sizeof(cap_tpm2), 64, 300*3);
+  TEST_ASSERT_EQUAL(1, r.pings);
+  TEST_ASSERT_EQUAL(2, r.frames.size());
+  assertFrame(r.frames[0], expected1, sizeof(expected1));
+  assertFrame(r.frames[1], expected2, sizeof(expected2));
+  TEST_ASSERT_EQUAL_STRING("\x36\x36", r.commands.c_str()); //end bytes, discarded
+}
+
+//a host configured for more LEDs than the strip has: the rest of the frame is received, but not stored
+void test_capacity()
+{
+  ParseResult r = feed(cap_ada_300leds, sizeof(cap_ada_300leds), 64, 30*3);
+  TEST_ASSERT_EQUAL(1, r.frames.size());
+  assertFrame(r.frames[0], cap_ada_300leds + 6, 30*3);
+
+  r = feed(cap_ada_4leds, sizeof(cap_ada_4leds), 64, 0);
+  TEST_ASSERT_EQUAL(2, r.frames.size());
+  TEST_ASSERT_EQUAL(0, r.frames[1].size());
+  TEST_ASSERT_EQUAL_STRING("v\n", r.commands.c_str());
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_adalight_frames);
+  RUN_TEST(test_block_sizes);
+  RUN_TEST(test_adalight_bad_checksum);
+  RUN_TEST(test_tpm2);
+  RUN_TEST(test_capacity);
+  return UNITY_END();
+}
@@ -73,6 +73,7 @@
 
 #define LED_SKIP_AMOUNT  1
 #define MIN_SHOW_DELAY   (_frametime < 16 ? 8 : 15)
+#define TX_TIMEOUT       1000 /* rendering is held back at most this long (ms) for an uncommitted transaction */
 
 #define NUM_COLORS       3 /* number of colors per segment */
 #define SEGMENT          _segments[_segment_index]
@@ -648,6 +649,8 @@ class WS2812FX {
       setTransitionMode(bool t),
       calcGammaTable(float),
       trigger(void),
+      beginTransaction(void),
+      commitTransaction(void),
       setSegment(uint8_t n, uint16_t start, uint16_t stop, uint8_t grouping = 0, uint8_t spacing = 0, uint16_t offset = UINT16_MAX),
       restartRuntime(),
       resetSegments(),
@@ -655,6 +658,7 @@ class WS2812FX {
       fixInvalidSegments(),
       setPixelColor(uint16_t n, uint32_t c),
       setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w = 0),
+      setRealtimePixels(uint16_t i, const uint8_t* data, uint16_t count, uint8_t format),
       show(void),
 			setTargetFps(uint8_t fps),
       deserializeMap(uint8_t n=0);
@@ -864,8 +868,11 @@ class WS2812FX {
     bool
       _isOffRefreshRequired = false, //periodic refresh is required for the strip to remain off.
       _hasWhiteChannel = false,
+      _txActive = false, //changes are staged, nothing is rendered until commitTransaction()
       _triggered;
 
+    uint32_t _txStart = 0, _txLast = 0;
+
     mode_ptr _mode[MODE_COUNT]; // SRAM footprint: 4 bytes per element
 
     show_callback _callback = nullptr;
@@ -929,6 +936,7 @@ class WS2812FX {
   public:
     inline bool hasWhiteChannel(void) {return _hasWhiteChannel;}
     inline bool isOffRefreshRequired(void) {return _isOffRefreshRequired;}
+    inline bool inTransaction(void) {return _txActive;}
 };
 
 //10 names per line
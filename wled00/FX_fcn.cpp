@@ -27,6 +27,8 @@
 #include "FX.h"
 #include "palettes.h"
 
+extern byte gammaT[]; //gamma lookup table, defined below
+
 /*
   Custom per-LED mapping has moved!
 
@@ -115,6 +117,10 @@ void WS2812FX::finalizeInit(void)
 void WS2812FX::service() {
   uint32_t nowUp = millis(); // Be aware, millis() rolls over every 49 days
   now = nowUp + timebase;
+  if (_txActive) {
+    if (nowUp - _txLast < TX_TIMEOUT) return; //changes are being staged, they are rendered together on commit
+    commitTransaction(); //never committed, render what we have
+  }
   if (nowUp - _lastShow < MIN_SHOW_DELAY) return;
   bool doShow = false;
 
@@ -229,6 +235,39 @@ void IRAM_ATTR WS2812FX::setPixelColor(uint16_t i, byte r, byte g, byte b, byte
   }
 }
 
+static inline uint32_t realtimeColor(const uint8_t* d, uint8_t stride, const uint8_t* g)
+{
+  uint8_t w = (stride == 4) ? d[3] : 0;
+  return g ? RGBW32(g[d[0]], g[d[1]], g[d[2]], g[w]) : RGBW32(d[0], d[1], d[2], w);
+}
+
+//bulk live data: sets count pixels from i on from a buffer of RGB or RGBW channels (see RT_PIXEL_ formats)
+//pixels are written bus by bus, so the bus lookup happens once per bus instead of once per pixel.
+//Like busses.setPixelColor(), every bus covering a pixel gets it (e.g. a network bus mirroring a physical one)
+void WS2812FX::setRealtimePixels(uint16_t i, const uint8_t* data, uint16_t count, uint8_t format)
+{
+  if (i >= _length) return;
+  if (count > _length - i) count = _length - i;
+  uint8_t stride = (format & RT_PIXEL_RGBW) ? 4 : 3;
+  const uint8_t* g = (format & RT_PIXEL_GAMMA) ? gammaT : nullptr;
+
+  if (customMappingTable) { //ledmap, pixels can land anywhere
+    for (uint16_t pix = i; pix < i + count; pix++, data += stride) {
+      busses.setPixelColor((pix < customMappingSize) ? customMappingTable[pix] : pix, realtimeColor(data, stride, g));
+    }
+    return;
+  }
+
+  for (uint8_t b = 0; b < busses.getNumBusses(); b++) {
+    Bus* bus = busses.getBus(b);
+    uint16_t bstart = bus->getStart();
+    uint16_t from = max(i, bstart);
+    uint16_t to = min(i + count, bstart + bus->getLength());
+    const uint8_t* d = data + (from - i) * stride;
+    for (uint16_t pix = from; pix < to; pix++, d += stride) bus->setPixelColor(pix - bstart, realtimeColor(d, stride, g));
+  }
+}
+
 
 //DISCLAIMER
 //The following function attemps to calculate the current LED power usage,
@@ -366,6 +405,31 @@ void WS2812FX::trigger() {
   _triggered = true;
 }
 
+/*
+ * Segment, effect and color changes made between beginTransaction() and commitTransaction()
+ * are not rendered until the commit, so a scene change spanning several segments or API calls
+ * never shows up half applied. Calling beginTransaction() again on an open transaction postpones
+ * the TX_TIMEOUT after which the changes are rendered even without a commit.
+ */
+void WS2812FX::beginTransaction() {
+  _txLast = millis();
+  if (_txActive) return;
+  _txStart = _txLast;
+  _txActive = true;
+}
+
+void WS2812FX::commitTransaction() {
+  if (!_txActive) return;
+  _txActive = false;
+  uint32_t nowUp = millis();
+  //transitions started while staging all start with the first frame showing the changes
+  for (uint8_t i = 0; i < MAX_NUM_TRANSITIONS; i++) {
+    if (transitions[i].segment == 0xFF) continue;
+    if (transitions[i].transitionStart - _txStart <= nowUp - _txStart) transitions[i].transitionStart = nowUp;
+  }
+  _triggered = true; //render all segments in the next frame
+}
+
 void WS2812FX::setMode(uint8_t segid, uint8_t m) {
   if (segid >= MAX_NUM_SEGMENTS) return;
    
@@ -458,7 +522,7 @@ void WS2812FX::setBrightness(uint8_t b) {
     }
   }
 	unsigned long t = millis();
-  if (_segment_runtimes[0].next_time > t + 22 && t - _lastShow > MIN_SHOW_DELAY) show(); //apply brightness change immediately if no refresh soon
+  if (!_txActive && _segment_runtimes[0].next_time > t + 22 && t - _lastShow > MIN_SHOW_DELAY) show(); //apply brightness change immediately if no refresh soon
 }
 
 uint8_t WS2812FX::getMode(void) {
@@ -1197,4 +1261,5 @@ WS2812FX* WS2812FX::instance = nullptr;
 //Bus static member definition, would belong in bus_manager.cpp
 int16_t Bus::_cct = -1;
 uint8_t Bus::_cctBlend = 0;
-uint8_t Bus::_autoWhiteMode = RGBW_MODE_DUAL;
\ No newline at end of file
+uint8_t Bus::_autoWhiteMode = RGBW_MODE_DUAL;
+bool BusNetwork::_deltaFrames = false;
\ No newline at end of file
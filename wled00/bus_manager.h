@@ -48,11 +48,13 @@ struct BusConfig {
   bool reversed;
   uint8_t skipAmount;
   bool refreshReq;
+  uint16_t universe; //first output universe of E1.31/Art-Net network busses
   uint8_t pins[5] = {LEDPIN, 255, 255, 255, 255};
   BusConfig(uint8_t busType, uint8_t* ppins, uint16_t pstart, uint16_t len = 1, uint8_t pcolorOrder = COL_ORDER_GRB, bool rev = false, uint8_t skip = 0) {
     refreshReq = (bool) GET_BIT(busType,7);
     type = busType & 0x7F;  // bit 7 may be/is hacked to include refresh info (1=refresh in off state, 0=no refresh)
     count = len; start = pstart; colorOrder = pcolorOrder; reversed = rev; skipAmount = skip;
+    universe = (type == TYPE_NET_ARTNET_RGB) ? 0 : 1; //Art-Net universes start at 0, E1.31 at 1
     uint8_t nPins = 1;
     if (type >= TYPE_NET_DDP_RGB && type < 96) nPins = 4; //virtual network bus. 4 "pins" store IP address
     else if (type > 47) nPins = 2;
@@ -151,6 +153,7 @@ class Bus {
     virtual void     setColorOrder() {}
     virtual uint8_t  getColorOrder() { return COL_ORDER_RGB; }
     virtual uint8_t  skippedLeds() { return 0; }
+    virtual uint16_t getUniverse() { return 0; }
     inline  uint16_t getStart() { return _start; }
     inline  void     setStart(uint16_t start) { _start = start; }
     inline  uint8_t  getType() { return _type; }
@@ -504,6 +507,17 @@ class BusNetwork : public Bus {
       if (_data == nullptr) return;
       memset(_data, 0, bc.count * _UDPchannels);
       _len = bc.count;
+      _universe = bc.universe;
+      if (_UDPtype == 0) { //DDP can address partial frames, track changed blocks of 16 pixels
+        _dirty = (byte *)calloc(dirtyLen(), 1);
+        if (_dirty == nullptr) { cleanup(); return; }
+      }
+      if (_UDPtype) { //E1.31 and Art-Net keep a sequence number for every universe
+        uint16_t chPerUniverse = _rgbw ? 512 : 510;
+        uint16_t numUniverses = ((uint32_t)_len * _UDPchannels + chPerUniverse -1) / chPerUniverse;
+        _seq = (byte *)calloc(numUniverses, 1);
+        if (_seq == nullptr) { cleanup(); return; }
+      }
       _client = IPAddress(bc.pins[0],bc.pins[1],bc.pins[2],bc.pins[3]);
       _broadcastLock = false;
       _valid = true;
@@ -514,6 +528,9 @@ class BusNetwork : public Bus {
 		if (isRgbw()) c = autoWhiteCalc(c);
     if (_cct >= 1900) c = colorBalanceFromKelvin(_cct, c); //color correction from CCT
     uint16_t offset = pix * _UDPchannels;
+    if (_dirty && (_data[offset] != R(c) || _data[offset+1] != G(c) || _data[offset+2] != B(c) || (_rgbw && _data[offset+3] != W(c)))) {
+      _dirty[pix >> 7] |= 0x01 << ((pix >> 4) & 0x07);
+    }
     _data[offset]   = R(c);
     _data[offset+1] = G(c);
     _data[offset+2] = B(c);
@@ -529,7 +546,14 @@ class BusNetwork : public Bus {
   void show() {
     if (!_valid || !canShow()) return;
     _broadcastLock = true;
-    realtimeBroadcast(_UDPtype, _client, _len, _data, _bri, _rgbw);
+    if (_dirty && _deltaFrames && _bri == _lastBri && millis() - _lastKeyframe < WLED_NET_KEYFRAME_MS) {
+      showChanged();
+    } else {
+      realtimeBroadcast(_UDPtype, _client, _len, _data, _bri, _rgbw, _universe, _seq);
+      _lastKeyframe = millis();
+      _lastBri = _bri;
+    }
+    if (_dirty) memset(_dirty, 0, dirtyLen());
     _broadcastLock = false;
   }
 
@@ -557,11 +581,22 @@ class BusNetwork : public Bus {
     return _len;
   }
 
+  inline uint16_t getUniverse() {
+    return _universe;
+  }
+
+  static void setDeltaFrames(bool en) { _deltaFrames = en; }
+  static bool getDeltaFrames() { return _deltaFrames; }
+
   void cleanup() {
     _type = I_NONE;
     _valid = false;
     if (_data != nullptr) free(_data);
     _data = nullptr;
+    if (_seq != nullptr) free(_seq);
+    _seq = nullptr;
+    if (_dirty != nullptr) free(_dirty);
+    _dirty = nullptr;
   }
 
   ~BusNetwork() {
@@ -576,6 +611,47 @@ class BusNetwork : public Bus {
     bool      _rgbw;
     bool      _broadcastLock;
     byte     *_data;
+    uint16_t  _universe = 1;
+    byte     *_seq = nullptr; //last sent sequence number of each universe (E1.31/Art-Net)
+    byte     *_dirty = nullptr; //bitmap of changed 16 pixel blocks since last show (DDP)
+    uint32_t  _lastKeyframe = 0;
+    uint8_t   _lastBri = 0;
+    static bool _deltaFrames;   //only send changed pixels between keyframes
+
+    inline uint16_t dirtyLen() {
+      return (((_len + 15) >> 4) + 7) >> 3;
+    }
+
+    inline bool isDirty(uint16_t block) {
+      return _dirty[block >> 3] & (0x01 << (block & 0x07));
+    }
+
+    //sends runs of changed blocks, the last one with the push flag
+    void showChanged() {
+      uint16_t blocks = (_len + 15) >> 4;
+      int32_t runStart = -1, pendingStart = -1;
+      uint16_t pendingEnd = 0;
+      for (uint16_t b = 0; b <= blocks; b++) {
+        if (b < blocks && isDirty(b)) {
+          if (runStart < 0) runStart = b;
+          continue;
+        }
+        //bridge a single unchanged block, cheaper than another packet header
+        if (b +1 < blocks && runStart >= 0 && isDirty(b +1)) continue;
+        if (runStart < 0) continue;
+        if (pendingStart >= 0) sendBlocks(pendingStart, pendingEnd, false);
+        pendingStart = runStart; pendingEnd = b;
+        runStart = -1;
+      }
+      if (pendingStart >= 0) sendBlocks(pendingStart, pendingEnd, true);
+    }
+
+    void sendBlocks(uint16_t first, uint16_t last, bool push) {
+      uint16_t start = first << 4;
+      uint16_t stop  = last << 4;
+      if (stop > _len) stop = _len;
+      realtimeBroadcastDDP(_client, start, stop - start, _data, _bri, _rgbw, push);
+    }
 };
 
 
@@ -632,6 +708,7 @@ class BusManager {
     for (uint8_t i = 0; i < numBusses; i++) {
       busses[i]->show();
     }
+    realtimeBroadcastSync(); //latch network nodes
   }
 
 	void setStatusPixel(uint32_t c) {
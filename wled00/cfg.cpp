@@ -86,6 +86,8 @@ bool deserializeConfig(JsonObject doc, bool fromFS) {
 	CJSON(strip.cctBlending, hw_led[F("cb")]);
 	Bus::setCCTBlend(strip.cctBlending);
 	strip.setTargetFps(hw_led["fps"]); //NOP if 0, default 42 FPS
+  CJSON(netOutputSync, hw_led[F("nsync")]);
+  BusNetwork::setDeltaFrames(hw_led[F("ndelta")] | BusNetwork::getDeltaFrames());
 
   JsonArray ins = hw_led["ins"];
   
@@ -116,6 +118,7 @@ bool deserializeConfig(JsonObject doc, bool fromFS) {
       ledType |= refresh << 7;  // hack bit 7 to indicate strip requires off refresh
       s++;
       BusConfig bc = BusConfig(ledType, pins, start, length, colorOrder, reversed, skipFirst);
+      CJSON(bc.universe, elm[F("uni")]);
       mem += BusManager::memUsage(bc);
       if (mem <= MAX_LED_MEMORY && busses.getNumBusses() <= WLED_MAX_BUSSES) busses.add(bc);  // finalization will be done in WLED::beginStrip()
     }
@@ -288,6 +291,7 @@ bool deserializeConfig(JsonObject doc, bool fromFS) {
   JsonObject if_live_dmx = if_live[F("dmx")];
   CJSON(e131Universe, if_live_dmx[F("uni")]);
   CJSON(e131SkipOutOfSequence, if_live_dmx[F("seqskip")]);
+  CJSON(e131FrameTimeout, if_live_dmx[F("ftmo")]);
   CJSON(DMXAddress, if_live_dmx[F("addr")]);
   CJSON(DMXMode, if_live_dmx["mode"]);
 
@@ -573,6 +577,8 @@ void serializeConfig() {
 	hw_led[F("cb")] = strip.cctBlending;
 	hw_led["fps"] = strip.getTargetFps();
 	hw_led[F("rgbwm")] = Bus::getAutoWhiteMode();
+  hw_led[F("nsync")] = netOutputSync;
+  hw_led[F("ndelta")] = BusNetwork::getDeltaFrames();
 
   JsonArray hw_led_ins = hw_led.createNestedArray("ins");
 
@@ -591,6 +597,7 @@ void serializeConfig() {
     ins[F("skip")] = bus->skippedLeds();
     ins["type"] = bus->getType() & 0x7F;
     ins["ref"] = bus->isOffRefreshRequired();
+    if (bus->getType() == TYPE_NET_E131_RGB || bus->getType() == TYPE_NET_ARTNET_RGB) ins[F("uni")] = bus->getUniverse();
     //ins[F("rgbw")] = bus->isRgbw();
   }
 
@@ -698,6 +705,7 @@ void serializeConfig() {
   JsonObject if_live_dmx = if_live.createNestedObject("dmx");
   if_live_dmx[F("uni")] = e131Universe;
   if_live_dmx[F("seqskip")] = e131SkipOutOfSequence;
+  if_live_dmx[F("ftmo")] = e131FrameTimeout;
   if_live_dmx[F("addr")] = DMXAddress;
   if_live_dmx["mode"] = DMXMode;
 
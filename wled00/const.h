@@ -110,6 +110,27 @@
 #define REALTIME_MODE_ARTNET      6
 #define REALTIME_MODE_TPM2NET     7
 #define REALTIME_MODE_DDP         8
+#define REALTIME_MODE_WS          9
+
+//realtime input statistics, counted per realtime mode
+#define RT_STAT_PACKETS           0            //packets received
+#define RT_STAT_FRAMES            1            //frames shown
+#define RT_STAT_GAPS              2            //packets missing according to sequence numbers
+#define RT_STAT_SKIPPED           3            //packets dropped as out of sequence
+#define RT_STAT_TORN              4            //frames shown incomplete
+#define RT_STAT_DUP               5            //duplicate packets dropped
+#define RT_STAT_COUNT             6
+
+//realtime pixel data formats (setRealtimePixels())
+#define RT_PIXEL_RGB              0x00         //3 channels per pixel
+#define RT_PIXEL_RGBW             0x01         //4 channels per pixel
+#define RT_PIXEL_GAMMA            0x02         //apply color gamma correction
+
+//binary LED snapshot ('L', version, flags, LED count hi, LED count lo, then pixel data)
+#define LIVE_SNAPSHOT_VERSION     2
+#define LIVE_SNAPSHOT_HEADER      5
+#define LIVE_SNAPSHOT_RLE         0x01         //pixel data is [run length -1, R, G, B] runs
+#define LIVE_SNAPSHOT_DELTA       0x02         //pixel data is [start hi, start lo, length -1, RGB...] spans changed since the last frame
 
 //realtime override modes
 #define REALTIME_OVERRIDE_NONE    0
@@ -280,6 +301,7 @@
 #define SETTINGS_STACK_BUF_SIZE 3096 
 #endif
 
+// multicast groups joined for E1.31 input (unicast input is sized from the LED count at runtime)
 #ifdef WLED_USE_ETHERNET
   #define E131_MAX_UNIVERSE_COUNT 20
 #else
@@ -290,6 +312,28 @@
   #endif
 #endif
 
+// time spent per loop draining pending UDP notifier/realtime packets
+#ifndef UDP_RECEIVE_BUDGET_US
+  #define UDP_RECEIVE_BUDGET_US 5000
+#endif
+
+// ms to wait for missing universes of a multi-universe frame before showing it anyway
+#define E131_FRAME_TIMEOUT 30
+
+// DDP frames with timecode held back for playout at their stamped time
+#ifndef DDP_JITTER_FRAMES
+  #ifdef ESP8266
+    #define DDP_JITTER_FRAMES 2
+  #else
+    #define DDP_JITTER_FRAMES 3
+  #endif
+#endif
+
+// full frame interval of network busses sending changes only, recovers from lost packets
+#ifndef WLED_NET_KEYFRAME_MS
+  #define WLED_NET_KEYFRAME_MS 1000
+#endif
+
 #define ABL_MILLIAMPS_DEFAULT 850  // auto lower brightness to stay close to milliampere limit
 
 // PWM settings
@@ -310,6 +354,32 @@
   #define JSON_BUFFER_SIZE 20480
 #endif
 
+// Document size for one part (state without segments, a single segment or info) of /json responses
+#define JSON_STREAM_DOC_SIZE 3072
+
+// Largest POST /json body accepted (JSON text or MessagePack)
+#define JSON_MAX_POST_SIZE 16384
+
+// ms the AsyncTCP task waits for the main loop to build the reply to a request (ESP32)
+#define JSON_REPLY_WAIT 250
+
+// JSON API commands received in async callbacks wait here until the main loop applies them
+#ifdef ESP8266
+  #define JSON_QUEUE_SIZE 4
+#else
+  #define JSON_QUEUE_SIZE 8
+#endif
+#define JSON_CMD_STATE    0            //apply with deserializeState()
+#define JSON_CMD_WS       1            //WebSocket message, handled by handleWsCommand()
+#define JSON_CMD_CFG      2            //apply with deserializeConfig()
+#define JSON_CMD_API      3            //HTTP API request ("win&..."), apply with handleSet(), client 1 if from the web server
+#define JSON_CMD_READ     4            //no command, only the reply (state and info of GET /json)
+#define JSON_CMD_MSGPACK  0x80         //flag: command is MessagePack instead of JSON text
+
+// MessagePack can be used instead of JSON for the state API (HTTP, WebSockets and UDP)
+#define MSGPACK_MIMETYPE  "application/msgpack"
+#define IS_MSGPACK_MAP(b) (((b) & 0xF0) == 0x80 || (b) == 0xDE || (b) == 0xDF) //first byte of a MessagePack map
+
 #ifdef WLED_USE_DYNAMIC_JSON
   #define MIN_HEAP_SIZE JSON_BUFFER_SIZE+512
 #else
@@ -3,49 +3,313 @@
 #define MAX_3_CH_LEDS_PER_UNIVERSE 170
 #define MAX_4_CH_LEDS_PER_UNIVERSE 128
 #define MAX_CHANNELS_PER_UNIVERSE 512
+#define ARTNET_SYNC_TIMEOUT 4000 //Art-Net falls back to latching without ArtSync after 4 seconds
+#define DDP_MAX_TIMECODE_DELAY 1000 //DDP timecodes further ahead are assumed to come from an unsynced clock
+#define DDP_JITTER_SLOTS (DDP_JITTER_FRAMES +1)
 
 /*
  * E1.31 handler
  */
 
+/*
+ * Receive buffers are shared by the packet callback and the main loop. On ESP32 the callback runs in the
+ * AsyncUDP task, so code (re)allocating, freeing or latching them holds RxLock. ESP8266 callbacks never
+ * preempt the loop, the lock is a no-op there.
+ */
+#ifdef ARDUINO_ARCH_ESP32
+static SemaphoreHandle_t rxMutex = xSemaphoreCreateMutex();
+class RxLock {
+  public:
+    RxLock()  { xSemaphoreTake(rxMutex, portMAX_DELAY); }
+    ~RxLock() { xSemaphoreGive(rxMutex); }
+};
+#else
+class RxLock {
+  public:
+    RxLock() {}
+};
+#endif
+
+/*
+ * Universe table
+ * One entry per universe we listen to, sized at runtime from the LED count and DMX settings.
+ * Each entry knows the LEDs its universe maps to, so a packet is written as a single span.
+ */
+typedef struct {
+  uint16_t led;      //first LED of the universe
+  uint16_t leds;     //LEDs in the universe
+  uint16_t channel;  //first LED channel in E1.31 packet data
+  uint16_t frame;    //rxFrameId of the frame the universe was last received for
+  uint8_t  seq;      //last sequence number, to detect packet loss
+  bool     seen;     //seq is valid
+} E131UniverseSpan;
+
+static E131UniverseSpan* rxUniTable = nullptr;
+static uint16_t rxUniCount = 0;          //entries in rxUniTable
+static uint16_t rxUniLeds = 0;           //LED count, DMX mode and address the table was built for
+static uint16_t rxUniAddress = 0;
+static byte     rxUniMode = DMX_MODE_DISABLED;
+
+/*
+ * Multi-universe frame assembly
+ * Universes of a frame are collected in a receive buffer and written to the strip at once (latched) when
+ * all universes have arrived, when the sync packet of the frame arrives or when e131FrameTimeout expires.
+ */
+static byte*    rxFrame = nullptr;       //received pixels, 3 or 4 bytes per LED (nullptr if one universe holds the frame)
+static uint32_t rxFrameLen = 0;          //size of rxFrame in bytes
+static uint8_t  rxFrameFormat = RT_PIXEL_RGB;
+static uint16_t rxFrameId = 1;           //current frame, universes whose frame matches have been received
+static uint16_t rxFrameUniverses = 0;    //universes of the current frame received so far
+static uint16_t rxUniSeen = 0;           //universes of the table the source has sent since the stream started
+static uint16_t rxSrcUniverses = 0;      //universes the source sends per frame, learned at each latch (0 = not known yet)
+static uint32_t rxFrameStart = 0;        //millis() when the first universe of the current frame arrived
+static uint16_t rxSyncUniverse = 0;      //E1.31 synchronization address of the current frame (0 = none)
+static byte     rxFrameMode = REALTIME_MODE_E131;
+static uint32_t artSyncTime = 0;         //millis() of the last ArtSync
+
+//number of universes we listen to, (re)builds the universe table if the LED count or DMX settings changed (caller holds RxLock)
+static uint16_t e131UniverseTable()
+{
+  uint16_t leds = realtimeFrameLeds();
+  if (rxUniTable && leds == rxUniLeds && DMXMode == rxUniMode && DMXAddress == rxUniAddress) return rxUniCount;
+
+  bool multi = (DMXMode == DMX_MODE_MULTIPLE_RGB || DMXMode == DMX_MODE_MULTIPLE_DRGB || DMXMode == DMX_MODE_MULTIPLE_RGBW);
+  const uint16_t dmxChannelsPerLed = (DMXMode == DMX_MODE_MULTIPLE_RGBW) ? 4 : 3;
+  const uint16_t ledsPerUniverse = (dmxChannelsPerLed == 4) ? MAX_4_CH_LEDS_PER_UNIVERSE : MAX_3_CH_LEDS_PER_UNIVERSE;
+  const uint16_t ledsInFirstUniverse = (MAX_CHANNELS_PER_UNIVERSE - DMXAddress) / dmxChannelsPerLed;
+  uint32_t count = 1;
+  if (multi && leds > ledsInFirstUniverse) count += (leds - ledsInFirstUniverse + ledsPerUniverse -1) / ledsPerUniverse;
+
+  free(rxUniTable);
+  rxUniTable = (E131UniverseSpan*)calloc(count, sizeof(E131UniverseSpan));
+  rxUniCount = rxUniTable ? count : 0;
+  rxUniLeds = leds; rxUniMode = DMXMode; rxUniAddress = DMXAddress;
+  rxFrameUniverses = 0;
+  rxUniSeen = rxSrcUniverses = 0;
+
+  uint16_t led = 0;
+  for (uint16_t i = 0; i < rxUniCount; i++) {
+    uint16_t n = i ? ledsPerUniverse : ledsInFirstUniverse;
+    rxUniTable[i].led  = led;
+    rxUniTable[i].leds = (leds - led < n) ? leds - led : n;
+    // All subsequent universes start at the first channel, the first DMX address is dimmer in DMX_MODE_MULTIPLE_DRGB mode.
+    rxUniTable[i].channel = i ? 1 : DMXAddress + (DMXMode == DMX_MODE_MULTIPLE_DRGB);
+    led += rxUniTable[i].leds;
+  }
+  DEBUG_PRINT(F("E1.31 universes: ")); DEBUG_PRINTLN(rxUniCount);
+  return rxUniCount;
+}
+
+uint16_t e131UniverseCount()
+{
+  RxLock lock;
+  return e131UniverseTable();
+}
+
+//(re)allocates the receive buffer, len 0 frees it
+static byte* e131FrameBuffer(uint32_t len)
+{
+  if (len != rxFrameLen) {
+    free(rxFrame);
+    rxFrame = len ? (byte*)calloc(len, 1) : nullptr;
+    rxFrameLen = rxFrame ? len : 0;
+  }
+  return rxFrame;
+}
+
+//writes the current frame to the strip and requests a show
+static void e131LatchFrame()
+{
+  if (!rxFrameUniverses) return;
+  rxSrcUniverses = rxUniSeen; //a sender may cover fewer universes than the table
+  if (rxFrameUniverses < rxSrcUniverses) realtimeStatsAdd(rxFrameMode, RT_STAT_TORN);
+  if (rxFrame && !realtimeOverride) {
+    uint8_t stride = (rxFrameFormat & RT_PIXEL_RGBW) ? 4 : 3;
+    setRealtimePixels(0, rxFrame, rxFrameLen / stride, rxFrameFormat | realtimeGamma());
+  }
+  if (!++rxFrameId) rxFrameId = 1; //0 is the frame of universes never received
+  rxFrameUniverses = 0;
+  rxSyncUniverse = 0;
+  e131NewData = true;
+}
+
+//E1.31 synchronization packet or ArtSync
+static void handleE131Sync(e131_packet_t* p, byte protocol)
+{
+  if (protocol == P_ARTNET_SYNC) {
+    artSyncTime = millis();
+  } else {
+    uint16_t syncUniverse = (p->raw[E131_SYNC_ADDR] << 8) | p->raw[E131_SYNC_ADDR +1];
+    if (!rxSyncUniverse || syncUniverse != rxSyncUniverse) return; //not the sync of our frame
+  }
+  e131LatchFrame();
+}
+
+//called from the main loop, shows incomplete frames once their universes stop arriving
+//and forgets the stream once when realtime mode ended. Returns right away unless one of those is due
+void handleE131FrameTimeout()
+{
+  if (!rxFrameUniverses && !rxUniSeen) return; //no frame pending and nothing received since the stream was forgotten
+  bool timedOut = rxFrameUniverses && millis() - rxFrameStart > e131FrameTimeout;
+  if (!timedOut && realtimeMode) return;
+  RxLock lock;
+  if (rxFrameUniverses && millis() - rxFrameStart > e131FrameTimeout) e131LatchFrame();
+  if (!realtimeMode && rxUniTable) { //realtime ended, forget the stream
+    for (uint16_t i = 0; i < rxUniCount; i++) rxUniTable[i].seen = false;
+    rxFrameUniverses = 0;
+    rxUniSeen = rxSrcUniverses = 0;
+    e131FrameBuffer(0);
+  }
+}
+
+/*
+ * DDP jitter buffer
+ * Frames with timecode are received into a ring of frame buffers and shown by handleDDPPlayout() once the
+ * toki clock reaches their timecode, hiding WiFi arrival jitter. ddpTail is the frame being received,
+ * ddpHead..ddpTail-1 are waiting for playout.
+ */
+static byte*    ddpFrames = nullptr;            //DDP_JITTER_SLOTS frames of 3 bytes per LED
+static uint16_t ddpFrameLen = 0;                //bytes per frame
+static uint32_t ddpDue[DDP_JITTER_SLOTS];       //millis() at which each queued frame is shown
+static volatile uint8_t ddpHead = 0, ddpTail = 0;
+static uint8_t  ddpTimecode[4];                 //timecode of the frame being received
+static bool     ddpTimedFill = false;           //a packet of the frame being received carried a timecode
+static uint8_t  ddpLastPushSeq = 0;             //sequence number of the last push, to reject late packets
+static uint8_t  ddpLastSeq = 0;                 //sequence number of the last packet, to count gaps
+
+//ms from now until a DDP timecode (middle 32 bits of an NTP timestamp: 16 bit seconds, 16 bit fraction) on the toki clock
+static int32_t ddpTimecodeDelay(const uint8_t* tc)
+{
+  Toki::Time now = toki.getTime();
+  uint16_t sec = (now.sec + YEARS_70) & 0xFFFF;
+  int32_t delay = (int16_t)(((tc[0] << 8) | tc[1]) - sec) * 1000;
+  delay += ((((tc[2] << 8) | tc[3]) * 1000UL) >> 16) - now.ms;
+  return delay;
+}
+
+//frame receiving DDP data with timecode, nullptr if the jitter buffer is not available
+static byte* ddpFillFrame()
+{
+  uint32_t len = realtimeFrameLeds() * 3;
+  if (len > UINT16_MAX) return nullptr;
+  if (len != ddpFrameLen) {
+    free(ddpFrames);
+    ddpFrames = len ? (byte*)calloc(DDP_JITTER_SLOTS, len) : nullptr;
+    ddpFrameLen = ddpFrames ? len : 0;
+    ddpHead = ddpTail = 0;
+  }
+  return ddpFrames ? ddpFrames + ddpTail * ddpFrameLen : nullptr;
+}
+
+//queues the received frame for playout at its timecode
+static void ddpQueueFrame()
+{
+  int32_t delay = ddpTimecodeDelay(ddpTimecode);
+  ddpTimedFrames++;
+  if (delay < 0) { //arrived after its timecode, play as soon as possible
+    ddpLateFrames++;
+    if (-delay > ddpMaxLate) ddpMaxLate = (-delay > UINT16_MAX) ? UINT16_MAX : -delay;
+    delay = 0;
+  }
+  if (delay > DDP_MAX_TIMECODE_DELAY) delay = 0; //sender clock is not synced to ours
+
+  uint8_t next = (ddpTail +1) % DDP_JITTER_SLOTS;
+  if (next == ddpHead) { //buffer full, the next frame keeps updating this one
+    ddpLateFrames++;
+    return;
+  }
+  ddpDue[ddpTail] = millis() + delay;
+  memcpy(ddpFrames + next * ddpFrameLen, ddpFrames + ddpTail * ddpFrameLen, ddpFrameLen); //packets of the next frame update this one
+  ddpTail = next;
+}
+
+//called from the main loop, shows the latest DDP frame whose timecode has been reached
+void handleDDPPlayout()
+{
+  if (!ddpFrames) return;
+  RxLock lock;
+  if (!realtimeMode) { //realtime ended
+    free(ddpFrames);
+    ddpFrames = nullptr;
+    ddpFrameLen = 0;
+    ddpHead = ddpTail = 0;
+    ddpJitterDepth = 0;
+    return;
+  }
+
+  uint8_t head = ddpHead, show = DDP_JITTER_SLOTS;
+  while (head != ddpTail && (int32_t)(millis() - ddpDue[head]) >= 0) {
+    if (show < DDP_JITTER_SLOTS) ddpLateFrames++; //superseded by a later frame before it could be shown
+    show = head;
+    head = (head +1) % DDP_JITTER_SLOTS;
+  }
+  if (show < DDP_JITTER_SLOTS) {
+    if (!realtimeOverride) setRealtimePixels(0, ddpFrames + show * ddpFrameLen, ddpFrameLen / 3, RT_PIXEL_RGB | realtimeGamma());
+    e131NewData = true;
+    ddpHead = head; //release the slot only after it was copied
+  }
+  ddpJitterDepth = (ddpTail + DDP_JITTER_SLOTS - ddpHead) % DDP_JITTER_SLOTS;
+}
+
 //DDP protocol support, called by handleE131Packet
 //handles RGB data only
 void handleDDPPacket(e131_packet_t* p) {
-  int lastPushSeq = e131LastSequenceNumber[0];
-  
+  RxLock lock;
+  int lastPushSeq = ddpLastPushSeq;
+  int sn = p->sequenceNum & 0xF; //1-15, 0 if not used
+
+  if (sn && ddpLastSeq) {
+    uint8_t gap = (sn - (ddpLastSeq % 15 +1) + 15) % 15;
+    if (gap && gap < 8) realtimeStatsAdd(REALTIME_MODE_DDP, RT_STAT_GAPS, gap);
+  }
+  if (sn) ddpLastSeq = sn;
+
   //reject late packets belonging to previous frame (assuming 4 packets max. before push)
-  if (e131SkipOutOfSequence && lastPushSeq) {
-    int sn = p->sequenceNum & 0xF;
-    if (sn) {
-      if (lastPushSeq > 5) {
-        if (sn > (lastPushSeq -5) && sn < lastPushSeq) return;
-      } else {
-        if (sn > (10 + lastPushSeq) || sn < lastPushSeq) return;
-      }
+  if (e131SkipOutOfSequence && lastPushSeq && sn) {
+    bool late;
+    if (lastPushSeq > 5) late = (sn > (lastPushSeq -5) && sn < lastPushSeq);
+    else                 late = (sn > (10 + lastPushSeq) || sn < lastPushSeq);
+    if (late) {
+      realtimeStatsAdd(REALTIME_MODE_DDP, RT_STAT_SKIPPED);
+      return;
     }
   }
 
   uint32_t start = htonl(p->channelOffset) /3;
   start += DMXAddress /3;
-  uint16_t stop = start + htons(p->dataLen) /3;
+  uint16_t count = htons(p->dataLen) /3;
   uint8_t* data = p->data;
   uint16_t c = 0;
-  if (p->flags & DDP_TIMECODE_FLAG) c = 4; //packet has timecode flag, we do not support it, but data starts 4 bytes later
+  byte* frame = nullptr;
+  if (p->flags & DDP_TIMECODE_FLAG) { //data starts after the 4 byte timecode
+    c = 4;
+    memcpy(ddpTimecode, data, 4);
+    ddpTimedFill = toki.getTimeSource() > 99; //timecode is only meaningful with a ms accurate clock
+  }
+  if (ddpTimedFill) frame = ddpFillFrame();
 
   realtimeLock(realtimeTimeoutMs, REALTIME_MODE_DDP);
-  
-  if (!realtimeOverride) {
-    for (uint16_t i = start; i < stop; i++) {
-      setRealtimePixel(i, data[c], data[c+1], data[c+2], 0);
-      c+=3;
+
+  if (frame) {
+    uint32_t offset = start * 3, len = count * 3;
+    if (offset < ddpFrameLen) {
+      if (len > ddpFrameLen - offset) len = ddpFrameLen - offset;
+      memcpy(frame + offset, data + c, len);
     }
+  } else if (!realtimeOverride && start <= UINT16_MAX) {
+    setRealtimePixels(start, data + c, count, RT_PIXEL_RGB | realtimeGamma());
   }
 
   bool push = p->flags & DDP_PUSH_FLAG;
   if (push) {
-    e131NewData = true;
+    ddpTimedFill = false;
+    if (frame) ddpQueueFrame();
+    else {
+      ddpHead = ddpTail; //untimed frame replaces anything still queued
+      e131NewData = true;
+    }
     byte sn = p->sequenceNum & 0xF;
-    if (sn) e131LastSequenceNumber[0] = sn;
+    if (sn) ddpLastPushSeq = sn;
   }
 }
 
@@ -68,8 +332,13 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
     dmxChannels = htons(p->property_value_count) -1;
     e131_data = p->property_values;
     seq = p->sequence_number;
+  } else if (protocol == P_E131_SYNC || protocol == P_ARTNET_SYNC) {
+    RxLock lock;
+    handleE131Sync(p, protocol);
+    return;
   } else { //DDP
     realtimeIP = clientIP;
+    realtimeStatsPacket(REALTIME_MODE_DDP, clientIP);
     handleDDPPacket(p);
     return;
   }
@@ -83,15 +352,31 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
   }
   #endif
 
-  // only listen for universes we're handling & allocated memory
-  if (uni >= (e131Universe + E131_MAX_UNIVERSE_COUNT)) return;
+  RxLock lock;
+  // only listen for universes we're handling
+  if (uni < e131Universe || uni - e131Universe >= e131UniverseTable()) return;
+
+  uint16_t previousUniverses = uni - e131Universe;
+  E131UniverseSpan &span = rxUniTable[previousUniverses];
+  realtimeStatsPacket(mde, clientIP);
 
-  uint8_t previousUniverses = uni - e131Universe;
+  if (span.seen && (seq || protocol == P_E131)) { //Art-Net sequence 0 means the sender does not use sequence numbers
+    //drop repeated packets
+    if (seq == span.seq) {
+      realtimeStatsAdd(mde, RT_STAT_DUP);
+      return;
+    }
+    uint8_t expected = span.seq +1;
+    if (protocol == P_ARTNET && !expected) expected = 1;
+    uint8_t gap = seq - expected;
+    if (gap && gap < 128) realtimeStatsAdd(mde, RT_STAT_GAPS, gap);
+  }
 
   if (e131SkipOutOfSequence)
-    if (seq < e131LastSequenceNumber[uni-e131Universe] && seq > 20 && e131LastSequenceNumber[uni-e131Universe] < 250){
+    if (seq < span.seq && seq > 20 && span.seq < 250){
+      realtimeStatsAdd(mde, RT_STAT_SKIPPED);
       DEBUG_PRINT("skipping E1.31 frame (last seq=");
-      DEBUG_PRINT(e131LastSequenceNumber[uni-e131Universe]);
+      DEBUG_PRINT(span.seq);
       DEBUG_PRINT(", current seq=");
       DEBUG_PRINT(seq);
       DEBUG_PRINT(", universe=");
@@ -99,7 +384,9 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
       DEBUG_PRINTLN(")");
       return;
     }
-  e131LastSequenceNumber[uni-e131Universe] = seq;
+  span.seq = seq;
+  if (!span.seen) rxUniSeen++;
+  span.seen = true;
 
   // update status info
   realtimeIP = clientIP;
@@ -169,38 +456,38 @@ void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol){
     case DMX_MODE_MULTIPLE_RGBW:
       {
         realtimeLock(realtimeTimeoutMs, mde);
+        if (realtimeOverride) return;
         bool is4Chan = (DMXMode == DMX_MODE_MULTIPLE_RGBW);
         const uint16_t dmxChannelsPerLed = is4Chan ? 4 : 3;
-        const uint16_t ledsPerUniverse = is4Chan ? MAX_4_CH_LEDS_PER_UNIVERSE : MAX_3_CH_LEDS_PER_UNIVERSE;
-        if (realtimeOverride) return;
-        uint16_t previousLeds, dmxOffset;
+        uint16_t dmxOffset = span.channel;
         if (previousUniverses == 0) {
           if (dmxChannels-DMXAddress < 1) return;
-          dmxOffset = DMXAddress;
-          previousLeds = 0;
-          // First DMX address is dimmer in DMX_MODE_MULTIPLE_DRGB mode.
-          if (DMXMode == DMX_MODE_MULTIPLE_DRGB) {
-            strip.setBrightness(e131_data[dmxOffset++]);
-          }
-        } else {
-          // All subsequent universes start at the first channel.
-          dmxOffset = (protocol == P_ARTNET) ? 0 : 1;
-          uint16_t ledsInFirstUniverse = (MAX_CHANNELS_PER_UNIVERSE - DMXAddress) / dmxChannelsPerLed;
-          previousLeds = ledsInFirstUniverse + (previousUniverses - 1) * ledsPerUniverse;
+          if (DMXMode == DMX_MODE_MULTIPLE_DRGB) strip.setBrightness(e131_data[DMXAddress]);
+        } else if (protocol == P_ARTNET) {
+          dmxOffset--; // Art-Net data has no start code
         }
-        uint16_t ledsTotal = previousLeds + (dmxChannels - dmxOffset +1) / dmxChannelsPerLed;
-        if (!is4Chan) {
-          for (uint16_t i = previousLeds; i < ledsTotal; i++) {
-            setRealtimePixel(i, e131_data[dmxOffset], e131_data[dmxOffset+1], e131_data[dmxOffset+2], 0);
-            dmxOffset+=3;
-          }
+
+        rxFrameMode = mde;
+        if (span.frame == rxFrameId) e131LatchFrame(); //universe repeats before the frame completed, the next frame has started
+        if (!rxFrameUniverses) rxFrameStart = millis();
+        span.frame = rxFrameId;
+        rxFrameUniverses++;
+
+        uint16_t leds = (dmxChannels +1 > dmxOffset) ? (dmxChannels - dmxOffset +1) / dmxChannelsPerLed : 0;
+        if (leds > span.leds) leds = span.leds;
+        rxFrameFormat = is4Chan ? RT_PIXEL_RGBW : RT_PIXEL_RGB;
+        if (e131FrameBuffer(rxUniCount > 1 ? (uint32_t)rxUniLeds * dmxChannelsPerLed : 0)) {
+          memcpy(rxFrame + span.led * dmxChannelsPerLed, e131_data + dmxOffset, leds * dmxChannelsPerLed);
         } else {
-          for (uint16_t i = previousLeds; i < ledsTotal; i++) {
-            setRealtimePixel(i, e131_data[dmxOffset], e131_data[dmxOffset+1], e131_data[dmxOffset+2], e131_data[dmxOffset+3]);
-            dmxOffset+=4;
-          }
+          setRealtimePixels(span.led, e131_data + dmxOffset, leds, rxFrameFormat | realtimeGamma());
         }
-        break;
+
+        //E1.31 data packets carry the universe of their sync packet, Art-Net senders announce sync mode by sending ArtSync
+        if (protocol == P_E131) rxSyncUniverse = htons(p->reserved);
+        bool waitSync = rxSyncUniverse || (protocol == P_ARTNET && artSyncTime && millis() - artSyncTime < ARTNET_SYNC_TIMEOUT);
+        //until a frame has been latched the universes the source sends are unknown, expect the whole table
+        if (!waitSync && rxFrameUniverses >= (rxSrcUniverses ? rxSrcUniverses : rxUniCount)) e131LatchFrame();
+        return;
       }
     default:
       DEBUG_PRINTLN(F("unknown E1.31 DMX mode"));
@@ -81,6 +81,9 @@ void handleDMX();
 
 //e131.cpp
 void handleE131Packet(e131_packet_t* p, IPAddress clientIP, byte protocol);
+uint16_t e131UniverseCount();
+void handleE131FrameTimeout();
+void handleDDPPlayout();
 
 //file.cpp
 bool handleFileRead(AsyncWebServerRequest*, String path);
@@ -134,9 +137,19 @@ void handleIR();
 void deserializeSegment(JsonObject elem, byte it, byte presetId = 0);
 bool deserializeState(JsonObject root, byte callMode = CALL_MODE_DIRECT_CHANGE, byte presetId = 0);
 void serializeSegment(JsonObject& root, WS2812FX::Segment& seg, byte id, bool forPreset = false, bool segmentBounds = true);
-void serializeState(JsonObject root, bool forPreset = false, bool includeBri = true, bool segmentBounds = true);
+void serializeState(JsonObject root, bool forPreset = false, bool includeBri = true, bool segmentBounds = true, bool includeSegments = true);
 void serializeInfo(JsonObject root);
+void updateStateRevision();
+DeserializationError deserializeCommand(JsonDocument& d, char* data, size_t len, bool msgPack = false);
+bool queueJsonCommand(const char* json, size_t len, byte source = JSON_CMD_STATE, uint32_t client = 0);
+void handleJsonCommands();
 void serveJson(AsyncWebServerRequest* request);
+void serveJsonCommand(AsyncWebServerRequest* request, const char* json, size_t len, byte source, bool verbose);
+void serveApiCommand(AsyncWebServerRequest* request, const char* req, size_t len);
+uint32_t writeLiveLeds(byte* buf, uint32_t size, bool& rle);
+uint32_t serializeLiveLedsBinary(byte* buf, uint32_t size, bool rle = false);
+uint32_t liveLedsBinarySize(bool rle = false);
+void serveLiveLedsBinary(AsyncWebServerRequest* request);
 #ifdef WLED_ENABLE_JSONLIVE
 bool serveLiveLeds(AsyncWebServerRequest* request, uint32_t wsClient = 0);
 #endif
@@ -160,6 +173,7 @@ void parseLxJson(int lxValue, byte segId, bool secondary);
 //mqtt.cpp
 bool initMqtt();
 void publishMqtt();
+void publishMqttRealtimeStats();
 
 //ntp.cpp
 void handleTime();
@@ -199,21 +213,36 @@ inline bool applyTemporaryPreset() {return applyPreset(255);};
 void savePreset(byte index, bool persist = true, const char* pname = nullptr, JsonObject saveobj = JsonObject());
 inline void saveTemporaryPreset() {savePreset(255, false);};
 void deletePreset(byte index);
+void initPresetStore();
+void handlePresetStore();
+void servePresetsJson(AsyncWebServerRequest* request);
 
 //set.cpp
 void _setRandomColor(bool _sec,bool fromButton=false);
 bool isAsterisksOnly(const char* str, byte maxLen);
-void handleSettingsSet(AsyncWebServerRequest *request, byte subPage);
-bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply=true);
-int getNumVal(const String* req, uint16_t pos);
+bool handleSettingsSet(AsyncWebServerRequest *request, byte subPage);
+bool handleSet(AsyncWebServerRequest *request, const char* req, bool apply=true, bool fromWeb=false);
+bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply=true, bool fromWeb=false);
 void parseNumber(const char* str, byte* val, byte minv=0, byte maxv=255);
-bool updateVal(const String* req, const char* key, byte* val, byte minv=0, byte maxv=255);
+bool updateVal(const char* str, byte* val, byte minv=0, byte maxv=255);
 
 //udp.cpp
 void notify(byte callMode, bool followUp=false);
-uint8_t realtimeBroadcast(uint8_t type, IPAddress client, uint16_t length, byte *buffer, uint8_t bri=255, bool isRGBW=false);
+uint8_t realtimeBroadcast(uint8_t type, IPAddress client, uint16_t length, byte *buffer, uint8_t bri=255, bool isRGBW=false, uint16_t universe=1, byte *seq=nullptr);
+uint8_t realtimeBroadcastDDP(IPAddress client, uint16_t start, uint16_t length, byte *buffer, uint8_t bri=255, bool isRGBW=false, bool push=true);
+void realtimeBroadcastSync();
 void realtimeLock(uint32_t timeoutMs, byte md = REALTIME_MODE_GENERIC);
+const __FlashStringHelper* realtimeModeName(byte md);
+void realtimeStatsAdd(byte md, uint8_t stat, uint16_t n = 1);
+void realtimeStatsPacket(byte md, IPAddress ip);
+void realtimeStatsShow();
+void handleRealtimeStats();
+void serializeRealtimeStats(JsonObject root);
+bool handleRealtimeDirect(const byte* data, uint16_t len, byte md);
 void handleNotifications();
+uint8_t realtimeGamma();
+uint16_t realtimeFrameLeds();
+void setRealtimePixels(uint16_t i, const byte* data, uint16_t count, uint8_t format);
 void setRealtimePixel(uint16_t i, byte r, byte g, byte b, byte w);
 void refreshNodeList();
 void sendSysInfoUDP();
@@ -226,6 +255,7 @@ void sendSysInfoUDP();
 //void prepareHostname(char* hostname);
 //void _setRandomColor(bool _sec, bool fromButton);
 //bool isAsterisksOnly(const char* str, byte maxLen);
+bool inLoopContext();
 bool requestJSONBufferLock(uint8_t module=255);
 void releaseJSONBufferLock();
 uint8_t extractModeName(uint8_t mode, const char *src, char *dest, uint8_t maxLen);
@@ -304,7 +334,9 @@ void serveSettings(AsyncWebServerRequest* request, bool post = false);
 //ws.cpp
 void handleWs();
 void wsEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsEventType type, void * arg, uint8_t *data, size_t len);
-void sendDataWs(AsyncWebSocketClient * client = nullptr);
+void sendDataWs(AsyncWebSocketClient * client = nullptr, bool msgPack = false);
+bool sendLiveSnapshotWs(AsyncWebSocketClient * client, bool rle = false);
+void handleWsCommand(uint32_t clientId, char* data, size_t len, bool msgPack = false);
 
 //xml.cpp
 void XML_response(AsyncWebServerRequest *request, char* dest = nullptr);
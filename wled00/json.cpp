@@ -1,6 +1,7 @@
 #include "wled.h"
 
 #include "palettes.h"
+#include <memory>
 
 /*
  * JSON API (De)serialization
@@ -249,6 +250,13 @@ bool deserializeState(JsonObject root, byte callMode, byte presetId)
   strip.applyToAllSelected = false;
   bool stateResponse = root[F("v")] | false;
 
+  //apply the whole command before the next frame is rendered. {"tx":true} keeps the transaction open
+  //for further commands (e.g. one per segment), the batch is shown at once with {"tx":false}
+  JsonVariant tx = root[F("tx")];
+  bool commitTx = !strip.inTransaction() || (tx.is<bool>() && !tx.as<bool>());
+  if (tx == true) commitTx = false;
+  strip.beginTransaction();
+
   getVal(root["bri"], &bri);
 
   bool on = root["on"] | (bri > 0);
@@ -370,6 +378,7 @@ bool deserializeState(JsonObject root, byte callMode, byte presetId)
       if (!presetId) unloadPlaylist(); //stop playlist if preset changed manually
       if (ps >= presetCycMin && ps <= presetCycMax) presetCycCurr = ps;
       applyPreset(ps, callMode);
+      if (commitTx) strip.commitTransaction();
       return stateResponse;
     }
 
@@ -392,10 +401,102 @@ bool deserializeState(JsonObject root, byte callMode, byte presetId)
   }
 
   colorUpdated(callMode);
+  if (commitTx) strip.commitTransaction();
 
   return stateResponse;
 }
 
+/*
+ * JSON command queue
+ * Async callbacks (web server, WebSockets, MQTT) only copy the received JSON here and never wait for the
+ * JSON buffer. The main loop parses and applies the commands in order, before the next frame is rendered.
+ * A command can carry the reply to its request, which the loop builds right after applying it (see JsonReply).
+ */
+class JsonReply;
+static void buildJsonReply(JsonReply* reply, bool cmdFailed);
+
+static struct {
+  char* json;                         //nullptr if the entry only asks for a reply (JSON_CMD_READ)
+  size_t len;
+  uint32_t client;
+  byte source;
+  std::shared_ptr<JsonReply> reply;
+} jsonQueue[JSON_QUEUE_SIZE];
+static volatile uint8_t jsonQueueHead = 0, jsonQueueTail = 0; //single producer (async), single consumer (main loop)
+
+//parses JSON text or MessagePack in place (strings point into data)
+DeserializationError deserializeCommand(JsonDocument& d, char* data, size_t len, bool msgPack)
+{
+  if (msgPack) return deserializeMsgPack(d, data, len);
+  return deserializeJson(d, data, len);
+}
+
+//false if the queue is full or out of memory (the command is dropped then)
+static bool queueCommand(const char* json, size_t len, byte source, uint32_t client, std::shared_ptr<JsonReply> reply)
+{
+  uint8_t next = (jsonQueueHead +1) % JSON_QUEUE_SIZE;
+  if ((!len && source != JSON_CMD_READ) || next == jsonQueueTail) return false;
+  char* buf = nullptr;
+  if (len) {
+    if (ESP.getFreeHeap() < len + MIN_HEAP_SIZE) return false;
+    buf = (char*)malloc(len +1);
+    if (!buf) return false;
+    memcpy(buf, json, len);
+    buf[len] = '\0';
+  }
+  jsonQueue[jsonQueueHead].json   = buf;
+  jsonQueue[jsonQueueHead].len    = len;
+  jsonQueue[jsonQueueHead].client = client;
+  jsonQueue[jsonQueueHead].source = source;
+  jsonQueue[jsonQueueHead].reply  = reply;
+  jsonQueueHead = next;
+  return true;
+}
+
+bool queueJsonCommand(const char* json, size_t len, byte source, uint32_t client)
+{
+  return queueCommand(json, len, source, client, nullptr);
+}
+
+void handleJsonCommands()
+{
+  while (jsonQueueTail != jsonQueueHead) {
+    char* json = jsonQueue[jsonQueueTail].json;
+    size_t len = jsonQueue[jsonQueueTail].len;
+    byte source = jsonQueue[jsonQueueTail].source & ~JSON_CMD_MSGPACK;
+    bool msgPack = jsonQueue[jsonQueueTail].source & JSON_CMD_MSGPACK;
+    bool failed = false;
+    if (source == JSON_CMD_READ) {
+      //reply only
+    } else if (source == JSON_CMD_WS) {
+      handleWsCommand(jsonQueue[jsonQueueTail].client, json, len, msgPack);
+    } else if (source == JSON_CMD_API) {
+      handleSet(nullptr, json, true, jsonQueue[jsonQueueTail].client);
+    } else {
+      #ifdef WLED_USE_DYNAMIC_JSON
+      DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+      #else
+      if (!requestJSONBufferLock(19)) return; //try again next loop
+      #endif
+      DeserializationError error = deserializeCommand(doc, json, len, msgPack);
+      JsonObject root = doc.as<JsonObject>();
+      failed = error || root.isNull();
+      if (!failed && source == JSON_CMD_CFG) {
+        if (deserializeConfig(root)) doSerializeConfig = true; //save new settings to FS
+      } else if (!failed) {
+        deserializeState(root);
+      }
+      releaseJSONBufferLock();
+    }
+    free(json);
+    if (jsonQueue[jsonQueueTail].reply) {
+      buildJsonReply(jsonQueue[jsonQueueTail].reply.get(), failed);
+      jsonQueue[jsonQueueTail].reply.reset();
+    }
+    jsonQueueTail = (jsonQueueTail +1) % JSON_QUEUE_SIZE;
+  }
+}
+
 void serializeSegment(JsonObject& root, WS2812FX::Segment& seg, byte id, bool forPreset, bool segmentBounds)
 {
   root["id"] = id;
@@ -447,7 +548,7 @@ void serializeSegment(JsonObject& root, WS2812FX::Segment& seg, byte id, bool fo
   root[F("mi")]  = seg.getOption(SEG_OPTION_MIRROR);
 }
 
-void serializeState(JsonObject root, bool forPreset, bool includeBri, bool segmentBounds)
+void serializeState(JsonObject root, bool forPreset, bool includeBri, bool segmentBounds, bool includeSegments)
 {
   if (includeBri) {
     root["on"] = (bri > 0);
@@ -482,6 +583,7 @@ void serializeState(JsonObject root, bool forPreset, bool includeBri, bool segme
   }
 
   root[F("mainseg")] = strip.getMainSegmentId();
+  if (!includeSegments) return;
 
   JsonArray seg = root.createNestedArray("seg");
   for (byte s = 0; s < strip.getMaxSegments(); s++) {
@@ -496,6 +598,50 @@ void serializeState(JsonObject root, bool forPreset, bool includeBri, bool segme
   }
 }
 
+//FNV-1a, cheap enough to fingerprint the state every loop
+static uint32_t hashAdd(uint32_t h, const void* data, size_t len)
+{
+  const byte* d = (const byte*)data;
+  while (len--) h = (h ^ *d++) * 16777619UL;
+  return h;
+}
+
+#define HASH_VAR(h, v) h = hashAdd(h, &(v), sizeof(v))
+
+/*
+ * Bumps stateRevision if anything serializeState() reports has changed since the last call,
+ * no matter which path (JSON/HTTP API, presets, playlists, buttons, notifications, ...) changed it.
+ * Called by the main loop and before a reply is built. Usermod state (addToJsonState()) is not covered.
+ */
+void updateStateRevision()
+{
+  static uint32_t lastHash = 0;
+  uint32_t h = 2166136261UL;
+  bool on = bri > 0;
+  int32_t nlRem = nightlightActive ? (int32_t)((nightlightDelayMs - (millis() - nightlightStartTime)) / 1000) : -1;
+  byte mainSeg = strip.getMainSegmentId();
+  HASH_VAR(h, on); HASH_VAR(h, briLast); HASH_VAR(h, transitionDelay);
+  h = hashAdd(h, col, 4); h = hashAdd(h, colSec, 4);
+  HASH_VAR(h, errorFlag); HASH_VAR(h, currentPreset); HASH_VAR(h, currentPlaylist);
+  HASH_VAR(h, nightlightActive); HASH_VAR(h, nightlightDelayMins); HASH_VAR(h, nightlightMode); HASH_VAR(h, nightlightTargetBri); HASH_VAR(h, nlRem);
+  HASH_VAR(h, notifyDirect); HASH_VAR(h, receiveNotifications); HASH_VAR(h, realtimeOverride); HASH_VAR(h, realtimeMode);
+  HASH_VAR(h, mainSeg);
+  for (byte s = 0; s < strip.getMaxSegments(); s++) {
+    WS2812FX::Segment &sg = strip.getSegment(s);
+    if (!sg.isActive()) continue;
+    byte options = sg.options & ~(0x01 << SEG_OPTION_TRANSITIONAL); //set while fading only
+    HASH_VAR(h, s);
+    HASH_VAR(h, sg.start); HASH_VAR(h, sg.stop); HASH_VAR(h, sg.offset);
+    HASH_VAR(h, sg.speed); HASH_VAR(h, sg.intensity); HASH_VAR(h, sg.palette); HASH_VAR(h, sg.mode); HASH_VAR(h, options);
+    HASH_VAR(h, sg.grouping); HASH_VAR(h, sg.spacing); HASH_VAR(h, sg.opacity); HASH_VAR(h, sg.cct);
+    h = hashAdd(h, sg.colors, sizeof(sg.colors));
+    if (sg.name) h = hashAdd(h, sg.name, strlen(sg.name));
+  }
+  if (h == lastHash) return;
+  lastHash = h;
+  stateRevision++;
+}
+
 //by https://github.com/tzapu/WiFiManager/blob/master/WiFiManager.cpp
 int getSignalQuality(int rssi)
 {
@@ -538,6 +684,12 @@ void serializeInfo(JsonObject root)
   leds["fps"] = strip.getFps();
   leds[F("maxpwr")] = (strip.currentMilliamps)? strip.ablMilliampsMax : 0;
   leds[F("maxseg")] = strip.getMaxSegments();
+  if (netOutTxUs) {
+    JsonObject netout = leds.createNestedObject(F("net"));
+    netout[F("sync")] = netOutputSync;
+    netout["tx"] = netOutTxUs;     //us to send a frame to all network busses
+    netout[F("skew")] = netOutSkewUs; //us between first and last node latching a frame
+  }
   //leds[F("seglock")] = false; //might be used in the future to prevent modifications to segment config
 
   root[F("str")] = syncToggleReceive;
@@ -546,17 +698,7 @@ void serializeInfo(JsonObject root)
   root[F("udpport")] = udpPort;
   root["live"] = (bool)realtimeMode;
 
-  switch (realtimeMode) {
-    case REALTIME_MODE_INACTIVE: root["lm"] = ""; break;
-    case REALTIME_MODE_GENERIC:  root["lm"] = ""; break;
-    case REALTIME_MODE_UDP:      root["lm"] = F("UDP"); break;
-    case REALTIME_MODE_HYPERION: root["lm"] = F("Hyperion"); break;
-    case REALTIME_MODE_E131:     root["lm"] = F("E1.31"); break;
-    case REALTIME_MODE_ADALIGHT: root["lm"] = F("USB Adalight/TPM2"); break;
-    case REALTIME_MODE_ARTNET:   root["lm"] = F("Art-Net"); break;
-    case REALTIME_MODE_TPM2NET:  root["lm"] = F("tpm2.net"); break;
-    case REALTIME_MODE_DDP:      root["lm"] = F("DDP"); break;
-  }
+  root["lm"] = realtimeModeName(realtimeMode);
 
   if (realtimeIP[0] == 0)
   {
@@ -565,6 +707,16 @@ void serializeInfo(JsonObject root)
     root[F("lip")] = realtimeIP.toString();
   }
 
+  serializeRealtimeStats(root.createNestedObject("rt"));
+
+  if (ddpTimedFrames) {
+    JsonObject ddpInfo = root.createNestedObject("ddp");
+    ddpInfo[F("depth")] = ddpJitterDepth;
+    ddpInfo[F("frames")] = ddpTimedFrames;
+    ddpInfo[F("late")] = ddpLateFrames;
+    ddpInfo[F("maxlate")] = ddpMaxLate;
+  }
+
   #ifdef WLED_ENABLE_WEBSOCKETS
   root[F("ws")] = ws.count();
   #else
@@ -698,7 +850,8 @@ void setPaletteColors(JsonArray json, byte* tcp)
     }
 }
 
-void serializePalettes(JsonObject root, AsyncWebServerRequest* request)
+//range of palettes [start, end) on the requested /json/palx page, returns the last page
+static int getPalettePage(AsyncWebServerRequest* request, int& page, int& start, int& end)
 {
   #ifdef ESP8266
   int itemPerPage = 5;
@@ -706,7 +859,7 @@ void serializePalettes(JsonObject root, AsyncWebServerRequest* request)
   int itemPerPage = 8;
   #endif
 
-  int page = 0;
+  page = 0;
   if (request->hasParam("page")) {
     page = request->getParam("page")->value().toInt();
   }
@@ -715,10 +868,18 @@ void serializePalettes(JsonObject root, AsyncWebServerRequest* request)
 
   int maxPage = (palettesCount -1) / itemPerPage;
   if (page > maxPage) page = maxPage;
+  if (page < 0) page = 0;
 
-  int start = itemPerPage * page;
-  int end = start + itemPerPage;
+  start = itemPerPage * page;
+  end = start + itemPerPage;
   if (end >= palettesCount) end = palettesCount;
+  return maxPage;
+}
+
+void serializePalettes(JsonObject root, AsyncWebServerRequest* request)
+{
+  int page, start, end;
+  int maxPage = getPalettePage(request, page, start, end);
 
   root[F("m")] = maxPage;
   JsonObject palettes  = root.createNestedObject("p");
@@ -802,6 +963,80 @@ void serializePalettes(JsonObject root, AsyncWebServerRequest* request)
   }
 }
 
+static void printPaletteColors(Print& out, const CRGBPalette16& palette)
+{
+  char buf[24];
+  for (int i = 0; i < 16; i++) {
+    CRGB color = palette[i];
+    snprintf_P(buf, sizeof(buf), PSTR("%s[%d,%u,%u,%u]"), i ? "," : "", i<<4, color.red, color.green, color.blue);
+    out.print(buf);
+  }
+}
+
+static void printPaletteColors(Print& out, const byte* gradient)
+{
+  char buf[24];
+  byte ent[4]; //index, r, g, b
+  bool first = true;
+  do {
+    memcpy_P(ent, gradient, 4);
+    gradient += 4;
+    snprintf_P(buf, sizeof(buf), PSTR("%s[%u,%u,%u,%u]"), first ? "" : ",", ent[0], ent[1], ent[2], ent[3]);
+    out.print(buf);
+    first = false;
+  } while (ent[0] < 255);
+}
+
+//same content as serializePalettes(), written straight from the palette data in flash.
+//It only changes with the firmware, so clients can revalidate their copy by ETag.
+static void servePalettesJson(AsyncWebServerRequest* request)
+{
+  int page, start, end;
+  int maxPage = getPalettePage(request, page, start, end);
+
+  char etag[32];
+  snprintf_P(etag, sizeof(etag), PSTR("\"p%lu-%d-%d\""), (unsigned long)VERSION, strip.getPaletteCount(), page);
+  AsyncWebHeader* header = request->getHeader("If-None-Match");
+  if (header && header->value() == etag) {
+    request->send(304);
+    return;
+  }
+
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+  response->addHeader(F("Cache-Control"), "no-cache");
+  response->addHeader(F("ETag"), etag);
+  response->printf("{\"m\":%d,\"p\":{", maxPage);
+  for (int i = start; i < end; i++) {
+    response->printf("%s\"%d\":[", (i > start) ? "," : "", i);
+    switch (i) {
+      case 0: //default palette
+      case 6: //Party colors
+        printPaletteColors(*response, PartyColors_p); break;
+      case 1: //random
+        response->print(F("\"r\",\"r\",\"r\",\"r\"")); break;
+      case 2: //primary color only
+        response->print(F("\"c1\"")); break;
+      case 3: //primary + secondary
+        response->print(F("\"c1\",\"c1\",\"c2\",\"c2\"")); break;
+      case 4: //primary + secondary + tertiary
+        response->print(F("\"c3\",\"c2\",\"c1\"")); break;
+      case 5: //primary + secondary (+tert if not off), more distinct
+        response->print(F("\"c1\",\"c1\",\"c1\",\"c1\",\"c1\",\"c2\",\"c2\",\"c2\",\"c2\",\"c2\",\"c3\",\"c3\",\"c3\",\"c3\",\"c3\",\"c1\"")); break;
+      case 7:  printPaletteColors(*response, CloudColors_p);         break;
+      case 8:  printPaletteColors(*response, LavaColors_p);          break;
+      case 9:  printPaletteColors(*response, OceanColors_p);         break;
+      case 10: printPaletteColors(*response, ForestColors_p);        break;
+      case 11: printPaletteColors(*response, RainbowColors_p);       break;
+      case 12: printPaletteColors(*response, RainbowStripeColors_p); break;
+      default:
+        printPaletteColors(*response, (const byte*)pgm_read_dword(&(gGradientPalettes[i - 13])));
+    }
+    response->print(']');
+  }
+  response->print(F("}}"));
+  request->send(response);
+}
+
 void serializeNodes(JsonObject root)
 {
   JsonArray nodes = root.createNestedArray("nodes");
@@ -820,6 +1055,306 @@ void serializeNodes(JsonObject root)
   }
 }
 
+#ifndef RESPONSE_TRY_AGAIN
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+#endif
+
+#ifdef ARDUINO_ARCH_ESP32
+static SemaphoreHandle_t jsonReplySem = xSemaphoreCreateBinary(); //given by the main loop whenever a reply was built
+#endif
+
+//ends a response that can not be completed, so the client sees an error instead of a 200 with truncated JSON.
+//Called from a response filler, the request must stay valid until it returned
+static void abortResponse(AsyncWebServerRequest* request)
+{
+  #ifdef ESP8266
+  request->client()->close(); //closed from the next poll
+  #else
+  request->client()->abort(); //the AsyncTCP task handles the disconnect after the filler returned
+  #endif
+}
+
+/*
+ * Reply to a command queued with serveJsonCommand() and /json, /json/state, /json/info and /json/si responses.
+ * The main loop builds the reply right after the command was applied (see handleJsonCommands()), so it reflects
+ * the result and the state is a consistent snapshot between two frames. The state, each segment and info are
+ * serialized part by part in small documents, so neither the global JSON buffer nor a document of the complete
+ * response is needed. Effect and palette names are sent from PROGMEM after the built text.
+ * The response does not wait for the TCP poll timer: on ESP32 the AsyncTCP task waits (at most JSON_REPLY_WAIT)
+ * for the loop to build the reply before starting the response, on ESP8266 the loop resumes the response itself.
+ */
+class JsonReply {
+  public:
+    enum : byte { REPLY_SUCCESS, REPLY_STATE, REPLY_XML };
+
+    JsonReply(byte type, byte subJson = 0, bool msgPack = false) : type(type), subJson(subJson), msgPack(msgPack) {}
+    ~JsonReply() { free(buf); }
+
+    bool ready() { return built; }
+    bool failed() { return error; }
+    bool isMsgPack() { return msgPack; }
+    uint32_t revision() { return builtRevision; }
+
+    //main loop, after the command was applied or could not be parsed
+    void build(bool cmdFailed) {
+      updateStateRevision(); //the revision of the state serialized below
+      builtRevision = stateRevision;
+      if (cmdFailed && type != REPLY_XML) flash(PSTR("{\"error\":9}"));
+      else if (type == REPLY_SUCCESS)     flash(PSTR("{\"success\":true}"));
+      else if (type == REPLY_STATE)       msgPack ? buildMsgPack() : buildState();
+      built = true;
+      #ifdef ARDUINO_ARCH_ESP32
+      xSemaphoreGive(jsonReplySem);
+      #else
+      if (request && request->client()->canSend()) response->_ack(request, 0, 0); //otherwise resumed by the next poll
+      #endif
+    }
+
+    #ifdef ARDUINO_ARCH_ESP32
+    //AsyncTCP task, returns once the reply was built or after JSON_REPLY_WAIT (the next poll sends it then)
+    void wait() {
+      unsigned long start = millis();
+      while (!built && millis() - start < JSON_REPLY_WAIT) xSemaphoreTake(jsonReplySem, pdMS_TO_TICKS(5));
+    }
+    #else
+    //the response build() resumes, cleared once the request is gone
+    void attach(AsyncWebServerRequest* req, AsyncWebServerResponse* res, std::shared_ptr<JsonReply> self) {
+      request = req;
+      response = res;
+      req->onDisconnect([self]() { self->request = nullptr; });
+    }
+    #endif
+
+    size_t fill(uint8_t* out, size_t maxLen) {
+      if (!built) return RESPONSE_TRY_AGAIN;
+      if (type == REPLY_XML && !buf && !error) serializeXmlReply(); //not from the loop, XML_response() uses the settings buffer
+      if (error) return 0;
+      size_t n = 0;
+      while (n < maxLen && sending <= flashParts) {
+        size_t l = sending ? flashLen[sending -1] : len;
+        size_t c = min(l - pos, maxLen - n);
+        if (sending) memcpy_P(out + n, flashPart[sending -1] + pos, c);
+        else         memcpy(out + n, buf + pos, c);
+        pos += c; n += c;
+        if (pos == l) {
+          sending++;
+          pos = 0;
+        }
+      }
+      return n;
+    }
+
+  private:
+    byte type, subJson;
+    bool msgPack;
+    volatile bool built = false;
+    bool error = false;            //out of memory or too large
+    uint32_t builtRevision = 0;
+    char* buf = nullptr;           //built by the main loop (JSON text, MessagePack or XML)
+    size_t len = 0, cap = 0;
+    const char* flashPart[5];      //sent after buf
+    size_t flashLen[5];
+    byte flashParts = 0;
+    byte sending = 0;              //0: buf, then flashPart[sending -1]
+    size_t pos = 0;
+    #ifdef ESP8266
+    AsyncWebServerRequest* request = nullptr;
+    AsyncWebServerResponse* response = nullptr;
+    #endif
+
+    bool fail() {
+      error = true;
+      return false;
+    }
+
+    void flash(PGM_P s) {
+      flashPart[flashParts] = s;
+      flashLen[flashParts++] = strlen_P(s);
+    }
+
+    //room for n more bytes in buf, which is limited to JSON_BUFFER_SIZE
+    bool reserve(size_t n) {
+      if (len + n +1 <= cap) return true;
+      size_t c = len + n +1 + 512; //grown in steps, fewer reallocations
+      if (c > JSON_BUFFER_SIZE || ESP.getFreeHeap() < c + MIN_HEAP_SIZE) return fail();
+      char* b = (char*)realloc(buf, c);
+      if (!b) return fail();
+      buf = b;
+      cap = c;
+      return true;
+    }
+
+    bool text(PGM_P s) {
+      size_t n = strlen_P(s);
+      if (!reserve(n)) return false;
+      memcpy_P(buf + len, s, n);
+      len += n;
+      return true;
+    }
+
+    //appends d serialized as JSON, after an optional PROGMEM prefix
+    bool append(JsonDocument& d, PGM_P prefix) {
+      if (d.overflowed()) return false;
+      size_t n = measureJson(d);
+      if ((prefix && !text(prefix)) || !reserve(n)) return fail();
+      serializeJson(d, buf + len, n +1);
+      len += n;
+      return true;
+    }
+
+    //appends one part (filled in by fn) from a JSON_STREAM_DOC_SIZE document, or from a larger one if that overflows
+    bool part(void (*fn)(JsonObject, byte), PGM_P prefix, byte seg = 0) {
+      {
+        DynamicJsonDocument d(JSON_STREAM_DOC_SIZE);
+        fn(d.to<JsonObject>(), seg);
+        if (!d.overflowed()) return append(d, prefix) || fail();
+      }
+      #ifndef WLED_USE_DYNAMIC_JSON
+      if (requestJSONBufferLock(24)) {
+        fn(doc.to<JsonObject>(), seg);
+        bool ok = append(doc, prefix);
+        releaseJSONBufferLock();
+        return ok || fail();
+      }
+      #endif
+      DynamicJsonDocument d(JSON_BUFFER_SIZE);
+      fn(d.to<JsonObject>(), seg);
+      return append(d, prefix) || fail();
+    }
+
+    void buildState() {
+      if (subJson != 2) {
+        if (subJson != 1 && !text(PSTR("{\"state\":"))) return;
+        if (!part([](JsonObject o, byte) { serializeState(o, false, true, true, false); }, nullptr)) return;
+        len--; //replaces the closing brace
+        if (!text(PSTR(",\"seg\":["))) return;
+        bool first = true;
+        for (byte s = 0; s < strip.getMaxSegments(); s++) {
+          if (!strip.getSegment(s).isActive()) continue;
+          if (!part([](JsonObject o, byte s) { serializeSegment(o, strip.getSegment(s), s); }, first ? nullptr : PSTR(","), s)) return;
+          first = false;
+        }
+        if (!text(PSTR("]}"))) return;
+      }
+      if (subJson == 1) return;
+      if (!part([](JsonObject o, byte) { serializeInfo(o); }, (subJson == 2) ? nullptr : PSTR(",\"info\":"))) return;
+      if (subJson == 2) return;
+      if (subJson == 3) {
+        text(PSTR("}"));
+        return;
+      }
+      flash(PSTR(",\"effects\":"));
+      flash(JSON_mode_names);
+      flash(PSTR(",\"palettes\":"));
+      flash(JSON_palette_names);
+      flash(PSTR("}"));
+    }
+
+    //same content as JSON, without effect and palette names (those are pre-serialized JSON)
+    void buildMsgPack() {
+      #ifdef WLED_USE_DYNAMIC_JSON
+      DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+      #else
+      if (!requestJSONBufferLock(23)) {
+        fail();
+        return;
+      }
+      #endif
+      JsonObject root = doc.to<JsonObject>();
+      if      (subJson == 1) serializeState(root);
+      else if (subJson == 2) serializeInfo(root);
+      else {
+        JsonObject state = root.createNestedObject("state");
+        serializeState(state);
+        JsonObject info = root.createNestedObject("info");
+        serializeInfo(info);
+      }
+      size_t n = measureMsgPack(doc);
+      if (reserve(n)) {
+        serializeMsgPack(doc, buf, n);
+        len = n;
+      }
+      releaseJSONBufferLock();
+    }
+
+    //state of the HTTP API (/win)
+    void serializeXmlReply() {
+      buf = (char*)malloc(1024);
+      if (!buf) {
+        fail();
+        return;
+      }
+      XML_response(nullptr, buf);
+      len = strlen(buf);
+    }
+};
+
+//called by handleJsonCommands(), JsonReply is not complete there
+static void buildJsonReply(JsonReply* reply, bool cmdFailed)
+{
+  reply->build(cmdFailed);
+}
+
+//MessagePack instead of JSON if the client asks for it (Accept header) or sent MessagePack itself
+static bool useMsgPack(AsyncWebServerRequest* request)
+{
+  AsyncWebHeader* header = request->getHeader("Accept");
+  if (header && header->value().indexOf(F("msgpack")) >= 0) return true;
+  return request->contentType().indexOf(F("msgpack")) >= 0;
+}
+
+//starts the response of a queued reply, with the ETag of the snapshot it holds if etag is set and it is built already
+static void sendJsonReply(AsyncWebServerRequest* request, std::shared_ptr<JsonReply> reply, const char* contentType, bool etag = false)
+{
+  #ifdef ARDUINO_ARCH_ESP32
+  reply->wait();
+  #endif
+  AsyncWebServerResponse *response = request->beginChunkedResponse(contentType,
+    [reply, request](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      size_t n = reply->fill(buffer, maxLen);
+      if (!n && reply->failed()) { //out of memory, do not end the response as if it were complete
+        abortResponse(request);
+        return RESPONSE_TRY_AGAIN;
+      }
+      return n;
+    });
+  if (etag && reply->ready()) { //only the revision of the snapshot sent matches its content
+    char tag[21];
+    snprintf_P(tag, sizeof(tag), PSTR("\"%08lx%08lx%s\""), (unsigned long)stateBootId, (unsigned long)reply->revision(), reply->isMsgPack() ? "m" : "");
+    response->addHeader(F("Cache-Control"), "no-cache");
+    response->addHeader(F("ETag"), tag);
+  }
+  #ifdef ESP8266
+  reply->attach(request, response, reply);
+  #endif
+  request->send(response);
+}
+
+//queues a POST /json command, answered once it was applied (with the resulting state if verbose)
+void serveJsonCommand(AsyncWebServerRequest* request, const char* json, size_t len, byte source, bool verbose)
+{
+  const String& url = request->url();
+  byte subJson = (url.indexOf("state") > 0) ? 1 : (url.indexOf("si") > 0) ? 3 : 0;
+  bool msgPack = verbose && useMsgPack(request);
+  std::shared_ptr<JsonReply> reply = std::make_shared<JsonReply>(verbose ? JsonReply::REPLY_STATE : JsonReply::REPLY_SUCCESS, subJson, msgPack);
+  if (!queueCommand(json, len, source, 0, reply)) {
+    request->send(503, "application/json", F("{\"error\":\"Busy\"}"));
+    return;
+  }
+  sendJsonReply(request, reply, msgPack ? MSGPACK_MIMETYPE : "application/json");
+}
+
+//queues an HTTP API (/win) request, answered with the XML state once it was applied
+void serveApiCommand(AsyncWebServerRequest* request, const char* req, size_t len)
+{
+  std::shared_ptr<JsonReply> reply = std::make_shared<JsonReply>(JsonReply::REPLY_XML);
+  if (!queueCommand(req, len, JSON_CMD_API, 1, reply)) {
+    request->send(503, "text/plain", F("Busy"));
+    return;
+  }
+  sendJsonReply(request, reply, "text/xml");
+}
+
 void serveJson(AsyncWebServerRequest* request)
 {
   byte subJson = 0;
@@ -829,12 +1364,22 @@ void serveJson(AsyncWebServerRequest* request)
   else if (url.indexOf("si")    > 0) subJson = 3;
   else if (url.indexOf("nodes") > 0) subJson = 4;
   else if (url.indexOf("palx")  > 0) subJson = 5;
-  #ifdef WLED_ENABLE_JSONLIVE
   else if (url.indexOf("live")  > 0) {
-    serveLiveLeds(request);
+    #ifdef WLED_ENABLE_JSONLIVE
+    if (!request->hasArg(F("bin"))) {
+      serveLiveLeds(request);
+      return;
+    }
+    #endif
+    serveLiveLedsBinary(request);
+    return;
+  }
+  else if (url.indexOf("rev")   > 0) { //cheap change poll
+    char buf[24];
+    snprintf_P(buf, sizeof(buf), PSTR("{\"rev\":%lu}"), (unsigned long)stateRevision);
+    request->send(200, "application/json", buf);
     return;
   }
-  #endif
   else if (url.indexOf(F("eff")) > 0) {
     request->send_P(200, "application/json", JSON_mode_names);
     return;
@@ -851,36 +1396,70 @@ void serveJson(AsyncWebServerRequest* request)
     return;
   }
 
+  bool msgPack = useMsgPack(request);
+  if (subJson == 5 && !msgPack) { //palette previews, do not need the JSON buffer
+    servePalettesJson(request);
+    return;
+  }
+
+  bool etag = (subJson == 1 && !errorFlag); //state can be revalidated without serializing it (a pending error is reported once)
+  if (etag) {
+    char tag[21];
+    snprintf_P(tag, sizeof(tag), PSTR("\"%08lx%08lx%s\""), (unsigned long)stateBootId, (unsigned long)stateRevision, msgPack ? "m" : "");
+    AsyncWebHeader* header = request->getHeader("If-None-Match");
+    if (header && header->value() == tag) {
+      request->send(304);
+      return;
+    }
+  }
+
+  if (subJson < 4) { //state, info or both, built by the main loop between two frames
+    std::shared_ptr<JsonReply> reply = std::make_shared<JsonReply>(JsonReply::REPLY_STATE, subJson, msgPack);
+    #ifdef ESP8266
+    //callbacks do not interrupt the loop, without commands pending the snapshot can be taken right away
+    if (jsonQueueTail == jsonQueueHead) reply->build(false);
+    else
+    #endif
+    if (!queueCommand(nullptr, 0, JSON_CMD_READ, 0, reply)) {
+      request->send(503, "application/json", F("{\"error\":\"Busy\"}"));
+      return;
+    }
+    sendJsonReply(request, reply, msgPack ? MSGPACK_MIMETYPE : "application/json", etag);
+    return;
+  }
+
+  if (msgPack) { //node list or palettes
+    #ifdef WLED_USE_DYNAMIC_JSON
+    DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+    #else
+    if (!requestJSONBufferLock(20)) {
+      request->send(503, "application/json", F("{\"error\":\"Busy\"}"));
+      return;
+    }
+    #endif
+    JsonObject root = doc.to<JsonObject>();
+    if (subJson == 4) serializeNodes(root);
+    else              serializePalettes(root, request);
+    AsyncResponseStream *response = request->beginResponseStream(MSGPACK_MIMETYPE, measureMsgPack(doc));
+    serializeMsgPack(doc, *response);
+    releaseJSONBufferLock();
+    request->send(response);
+    return;
+  }
+
   #ifdef WLED_USE_DYNAMIC_JSON
   AsyncJsonResponse* response = new AsyncJsonResponse(JSON_BUFFER_SIZE);
   #else
-  if (!requestJSONBufferLock(17)) return;
+  if (!requestJSONBufferLock(17)) {
+    request->send(503, "application/json", F("{\"error\":\"Busy\"}"));
+    return;
+  }
   AsyncJsonResponse *response = new AsyncJsonResponse(&doc);
   #endif
 
   JsonObject lDoc = response->getRoot();
 
-  switch (subJson)
-  {
-    case 1: //state
-      serializeState(lDoc); break;
-    case 2: //info
-      serializeInfo(lDoc); break;
-    case 4: //node list
-      serializeNodes(lDoc); break;
-    case 5: //palettes
-      serializePalettes(lDoc, request); break;
-    default: //all
-      JsonObject state = lDoc.createNestedObject("state");
-      serializeState(state);
-      JsonObject info = lDoc.createNestedObject("info");
-      serializeInfo(info);
-      if (subJson != 3)
-      {
-        doc[F("effects")]  = serialized((const __FlashStringHelper*)JSON_mode_names);
-        doc[F("palettes")] = serialized((const __FlashStringHelper*)JSON_palette_names);
-      }
-  }
+  serializeNodes(lDoc); //node list, palettes and state/info are served above
 
   DEBUG_PRINT("JSON buffer size: ");
   DEBUG_PRINTLN(lDoc.memoryUsage());
@@ -890,6 +1469,101 @@ void serveJson(AsyncWebServerRequest* request)
   releaseJSONBufferLock();
 }
 
+static inline uint32_t liveColor(uint16_t i)
+{
+  uint32_t c = strip.getPixelColor(i);
+  return RGBW32(qadd8(W(c), R(c)), qadd8(W(c), G(c)), qadd8(W(c), B(c)), 0); //add white channel to RGB channels as a simple RGBW -> RGB map
+}
+
+//number of LEDs from i on with color c, at most 256
+static uint16_t liveRun(uint16_t i, uint16_t used, uint32_t c)
+{
+  uint16_t run = 1;
+  while (i + run < used && run < 256 && liveColor(i + run) == c) run++;
+  return run;
+}
+
+//writes RGB data of all LEDs to buf (size at least 3 bytes per LED), buf may be nullptr to only get the length
+//if rle is set, runs of equal colors are written as [run length -1, R, G, B] instead,
+//unless that would not be smaller than the raw data or not fit size, in which case rle is cleared
+uint32_t writeLiveLeds(byte* buf, uint32_t size, bool& rle)
+{
+  uint16_t used = strip.getLengthTotal();
+  uint32_t raw = used*3;
+
+  if (rle) {
+    uint32_t pos = 0;
+    uint16_t i = 0;
+    while (i < used) {
+      if (pos +4 >= raw || pos +4 > size) break; //RLE is no gain or does not fit
+      uint32_t c = liveColor(i);
+      uint16_t run = liveRun(i, used, c);
+      if (buf) {
+        buf[pos]   = run -1;
+        buf[pos+1] = R(c);
+        buf[pos+2] = G(c);
+        buf[pos+3] = B(c);
+      }
+      pos += 4;
+      i += run;
+    }
+    if (i == used) return pos;
+    rle = false;
+  }
+
+  if (size < raw) return 0;
+  if (!buf) return raw;
+  for (uint16_t i = 0; i < used; i++) {
+    uint32_t c = liveColor(i);
+    *buf++ = R(c);
+    *buf++ = G(c);
+    *buf++ = B(c);
+  }
+  return raw;
+}
+
+//complete binary snapshot (header + pixel data), buf needs liveLedsBinarySize(rle) bytes
+uint32_t serializeLiveLedsBinary(byte* buf, uint32_t size, bool rle)
+{
+  if (size < LIVE_SNAPSHOT_HEADER) return 0;
+  uint16_t used = strip.getLengthTotal();
+  uint32_t len = writeLiveLeds(buf + LIVE_SNAPSHOT_HEADER, size - LIVE_SNAPSHOT_HEADER, rle);
+  if (!len && used) return 0;
+  buf[0] = 'L';
+  buf[1] = LIVE_SNAPSHOT_VERSION;
+  buf[2] = rle ? LIVE_SNAPSHOT_RLE : 0;
+  buf[3] = used >> 8;
+  buf[4] = used & 0xFF;
+  return LIVE_SNAPSHOT_HEADER + len;
+}
+
+//size of the snapshot of the current frame, with rle the run-length encoded size if that is smaller
+uint32_t liveLedsBinarySize(bool rle)
+{
+  return LIVE_SNAPSHOT_HEADER + writeLiveLeds(nullptr, UINT32_MAX, rle);
+}
+
+//full resolution snapshot as application/octet-stream, "rle" argument for run-length encoding
+//the frame is captured into a single buffer first (sized for raw data, RLE is only used if it is smaller),
+//so the snapshot, its header and its length all come from the same pass over the LEDs
+void serveLiveLedsBinary(AsyncWebServerRequest* request)
+{
+  uint32_t size = LIVE_SNAPSHOT_HEADER + strip.getLengthTotal()*3;
+  std::shared_ptr<byte> buf((ESP.getFreeHeap() > size + MIN_HEAP_SIZE) ? (byte*)malloc(size) : nullptr, free);
+  uint32_t len = buf ? serializeLiveLedsBinary(buf.get(), size, request->hasArg(F("rle"))) : 0;
+  if (!len) {
+    request->send(503, "application/json", F("{\"error\":\"Busy\"}"));
+    return;
+  }
+  AsyncWebServerResponse *response = request->beginResponse("application/octet-stream", len,
+    [buf, len](uint8_t* out, size_t maxLen, size_t index) -> size_t {
+      size_t c = min((size_t)(len - index), maxLen);
+      memcpy(out, buf.get() + index, c);
+      return c;
+    });
+  request->send(response);
+}
+
 #ifdef WLED_ENABLE_JSONLIVE
 #define MAX_LIVE_LEDS 180
 
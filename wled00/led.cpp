@@ -159,6 +159,10 @@ void handleTransitions()
   
   if (transitionActive && transitionDelayTemp > 0)
   {
+    if (strip.inTransaction()) { //changes are staged, the transition starts once they are committed
+      transitionStartTime = millis();
+      return;
+    }
     float tper = (millis() - transitionStartTime)/(float)transitionDelayTemp;
     if (tper >= 1.0)
     {
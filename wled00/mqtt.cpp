@@ -90,19 +90,12 @@ void onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties
     colorFromDecOrHexString(col, (char*)payloadStr);
     colorUpdated(CALL_MODE_DIRECT_CHANGE);
   } else if (strcmp_P(topic, PSTR("/api")) == 0) {
-    if (payload[0] == '{') { //JSON API
-      #ifdef WLED_USE_DYNAMIC_JSON
-      DynamicJsonDocument doc(JSON_BUFFER_SIZE);
-      #else
-      if (!requestJSONBufferLock(15)) return;
-      #endif
-      deserializeJson(doc, payloadStr);
-      deserializeState(doc.as<JsonObject>());
-      releaseJSONBufferLock();
+    if (payload[0] == '{') { //JSON API, applied by the main loop
+      queueJsonCommand(payloadStr, strlen(payloadStr));
     } else { //HTTP API
       String apireq = "win&";
       apireq += (char*)payloadStr;
-      handleSet(nullptr, apireq);
+      queueJsonCommand(apireq.c_str(), apireq.length(), JSON_CMD_API);
     }
   } else if (strlen(topic) != 0) {
     // non standard topic, check with usermods
@@ -146,6 +139,23 @@ void publishMqtt()
 }
 
 
+//publishes realtime input statistics (same as "rt" in /json/info) while receiving realtime data
+void publishMqttRealtimeStats()
+{
+  if (!WLED_MQTT_CONNECTED) return;
+
+  DynamicJsonDocument stats(1024);
+  serializeRealtimeStats(stats.to<JsonObject>());
+  char payload[1024];
+  serializeJson(stats, payload, sizeof(payload));
+
+  char subuf[38];
+  strlcpy(subuf, mqttDeviceTopic, 33);
+  strcat_P(subuf, PSTR("/rt"));
+  mqtt->publish(subuf, 0, false, payload);  // do not retain message
+}
+
+
 //HA autodiscovery was removed in favor of the native integration in HA v0.102.0
 
 bool initMqtt()
@@ -181,4 +191,5 @@ bool initMqtt()
 #else
 bool initMqtt(){return false;}
 void publishMqtt(){}
+void publishMqttRealtimeStats(){}
 #endif
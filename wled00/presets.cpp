@@ -1,14 +1,762 @@
 #include "wled.h"
+#include <memory>
 
 /*
  * Methods to handle saving and loading presets to/from the filesystem
  */
 
+/*
+ * Preset store: presets are appended as records to a log file.
+ * Record: [0xA5][id][length lo][length hi][preset JSON, length bytes][CRC32 of id, length and JSON, LSB first]
+ * A record with length 0 deletes the preset. Only the newest record of each preset is valid, the position
+ * of it is kept in RAM. Space taken by replaced and deleted presets is reclaimed in the background by
+ * handlePresetStore() once no preset was saved for a while.
+ * The UI keeps using presets.json: it is generated from the store on request, and an uploaded one is imported.
+ * presets.json is also kept on the filesystem as a mirror of the store, rewritten in the background once no preset
+ * was saved for a while, so a downgrade to a version without the store still finds the presets. PSTORE_JSON_SUM
+ * identifies the mirror: a presets.json that does not match it (uploaded, or changed by an older version) is imported.
+ * The store is only changed from the main loop, requests from async callbacks are queued as JSON commands.
+ */
+#define PSTORE_FILE     "/presets.bin"
+#define PSTORE_TMP      "/presets.tmp"
+#define PSTORE_JSON     "/presets.json"
+#define PSTORE_JSON_TMP "/presets.jtmp"
+#define PSTORE_JSON_SUM "/presets.sum"  //size and CRC32 of the presets.json mirror, LSB first
+#define PSTORE_MAGIC    "WPS1"         //file header
+#define PSTORE_SYNC     0xA5           //first byte of each record
+#define PSTORE_OVERHEAD 8              //record header and CRC
+#define PSTORE_MAX_ID   250            //persistent presets 1-250, 255 is the temporary one in tmp.json
+#define PSTORE_BUFSIZE  256
+#define PSTORE_COMPACT_MIN   4096      //compact once this many bytes are taken by dead records
+#define PSTORE_COMPACT_DELAY 5000      //ms without preset changes before compacting
+
+static uint32_t* presetPos = nullptr;   //position of the newest record of each preset, 0 if it does not exist
+static uint32_t presetStoreEnd = 0;     //where the next record is appended
+static uint32_t presetStoreDead = 0;    //bytes taken by replaced and deleted records
+static unsigned long lastPresetWrite = 0;
+static volatile uint8_t presetStoreReaders = 0; //running presets.json exports, import and compaction wait for them
+static volatile bool presetStoreBusy = false;   //import or compaction step running, exports are refused meanwhile
+static File compactSrc, compactDst;
+static uint8_t compactId = 0;           //next preset to copy to the compacted store, 0 if not compacting
+static bool presetJsonDirty = false;    //presets.json mirror is older than the store
+
+class PresetExporter;
+static PresetExporter* jsonMirror = nullptr; //presets.json mirror being written, see mirrorPresetsJson()
+static File jsonMirrorFile;
+static uint32_t jsonMirrorSize = 0, jsonMirrorCrc = 0;
+static void abortPresetsJsonMirror();
+
+#ifdef ARDUINO_ARCH_ESP32
+static portMUX_TYPE presetStoreMux = portMUX_INITIALIZER_UNLOCKED; //exports start in the AsyncTCP task
+#define PSTORE_ENTER portENTER_CRITICAL(&presetStoreMux)
+#define PSTORE_EXIT  portEXIT_CRITICAL(&presetStoreMux)
+#else
+#define PSTORE_ENTER
+#define PSTORE_EXIT
+#endif
+
+//claims the store for import or compaction, false while presets.json is being exported
+static bool lockPresetStore()
+{
+  PSTORE_ENTER;
+  bool locked = !presetStoreReaders;
+  if (locked) presetStoreBusy = true;
+  PSTORE_EXIT;
+  return locked;
+}
+
+static void unlockPresetStore()
+{
+  presetStoreBusy = false;
+}
+
+static uint32_t crc32Update(uint32_t crc, const byte* data, size_t len)
+{
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+//serializes a preset into the store file, buffered and computing the CRC along the way
+class PresetRecordWriter : public Print {
+  public:
+    uint32_t crc;
+    size_t stored = 0;
+
+    PresetRecordWriter(File& file, uint32_t crcInit) : crc(crcInit), _f(file) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+
+    size_t write(const uint8_t* data, size_t len) override {
+      crc = crc32Update(crc, data, len);
+      for (size_t i = 0; i < len; i++) {
+        _buf[_n++] = data[i];
+        if (_n == sizeof(_buf)) flushBuffer();
+      }
+      return len;
+    }
+
+    void flushBuffer() {
+      if (_n) stored += _f.write(_buf, _n);
+      _n = 0;
+    }
+
+  private:
+    File& _f;
+    byte _buf[64];
+    uint8_t _n = 0;
+};
+
+//writes a record at the current file position, returns its size or 0 on failure
+static uint32_t writePresetRecord(File& sf, uint8_t id, JsonDocument* content)
+{
+  size_t len = content->isNull() ? 0 : measureJson(*content);
+  if (len > UINT16_MAX) return 0;
+  byte hdr[4] = {PSTORE_SYNC, id, (byte)(len & 0xFF), (byte)(len >> 8)};
+  if (sf.write(hdr, 4) != 4) return 0;
+  PresetRecordWriter w(sf, crc32Update(0, hdr +1, 3));
+  if (len) serializeJson(*content, w);
+  w.flushBuffer();
+  if (w.stored != len) return 0;
+  byte crc[4] = {(byte)w.crc, (byte)(w.crc >> 8), (byte)(w.crc >> 16), (byte)(w.crc >> 24)};
+  if (sf.write(crc, 4) != 4) return 0;
+  return len + PSTORE_OVERHEAD;
+}
+
+static bool readRecordHeader(File& sf, uint32_t pos, uint8_t& id, uint16_t& len)
+{
+  byte hdr[4];
+  if (!sf.seek(pos) || sf.read(hdr, 4) != 4 || hdr[0] != PSTORE_SYNC) return false;
+  id = hdr[1];
+  len = hdr[2] | (hdr[3] << 8);
+  return true;
+}
+
+//true if a complete record with a valid CRC starts at pos
+static bool checkPresetRecord(File& sf, uint32_t pos, uint32_t size, uint8_t& id, uint16_t& len)
+{
+  if (!readRecordHeader(sf, pos, id, len) || pos + PSTORE_OVERHEAD + len > size) return false;
+  byte buf[PSTORE_BUFSIZE];
+  byte hdr[3] = {id, (byte)(len & 0xFF), (byte)(len >> 8)};
+  uint32_t crc = crc32Update(0, hdr, 3);
+  uint16_t left = len;
+  while (left) {
+    size_t n = sf.read(buf, left < PSTORE_BUFSIZE ? left : PSTORE_BUFSIZE);
+    if (!n) return false;
+    crc = crc32Update(crc, buf, n);
+    left -= n;
+  }
+  if (sf.read(buf, 4) != 4) return false;
+  return crc == (buf[0] | (buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24));
+}
+
+//position of the next sync byte at or after pos, size if there is none
+static uint32_t findRecordSync(File& sf, uint32_t pos, uint32_t size)
+{
+  byte buf[PSTORE_BUFSIZE];
+  if (!sf.seek(pos)) return size;
+  while (pos < size) {
+    size_t n = sf.read(buf, PSTORE_BUFSIZE);
+    if (!n) return size;
+    byte* sync = (byte*)memchr(buf, PSTORE_SYNC, n);
+    if (sync) return pos + (sync - buf);
+    pos += n;
+  }
+  return size;
+}
+
+//rebuilds the index by reading the whole store once. A damaged record is skipped by resyncing on the next
+//sync byte that starts a record with a valid CRC, so the records after it are kept
+static bool scanPresetStore()
+{
+  #ifdef WLED_DEBUG_FS
+    DEBUGFS_PRINTLN(F("Scan preset store"));
+    uint32_t s = millis();
+  #endif
+  memset(presetPos, 0, (PSTORE_MAX_ID +1) * sizeof(uint32_t));
+  presetStoreEnd = 0;
+  presetStoreDead = 0;
+  File sf = WLED_FS.open(PSTORE_FILE, "r");
+  if (!sf) return false;
+  char magic[4];
+  if (sf.read((byte*)magic, 4) != 4 || memcmp_P(magic, PSTR(PSTORE_MAGIC), 4)) {
+    sf.close();
+    return false;
+  }
+
+  uint32_t size = sf.size(), pos = 4, end = 4, live = 0;
+  uint16_t* lens = (uint16_t*)calloc(PSTORE_MAX_ID +1, sizeof(uint16_t)); //only needed to sum up the live records
+  while (pos + PSTORE_OVERHEAD <= size) {
+    uint8_t id; uint16_t len;
+    if (!checkPresetRecord(sf, pos, size, id, len)) {
+      DEBUGFS_PRINTF("Damaged record at %d\n", pos);
+      pos = findRecordSync(sf, pos +1, size);
+      continue;
+    }
+    if (id && id <= PSTORE_MAX_ID) {
+      presetPos[id] = len ? pos : 0;
+      if (lens) lens[id] = len;
+    }
+    pos += PSTORE_OVERHEAD + len;
+    end = pos;
+  }
+  sf.close();
+
+  for (uint8_t i = 1; i <= PSTORE_MAX_ID; i++) if (presetPos[i] && lens) live += PSTORE_OVERHEAD + lens[i];
+  free(lens);
+  presetStoreEnd = end; //after the last valid record, a damaged tail is overwritten by the next record
+  presetStoreDead = lens ? end - 4 - live : 0; //damaged records in between are dead, removed by compaction
+  DEBUGFS_PRINTF("Store end %d, dead %d, took %d ms\n", presetStoreEnd, presetStoreDead, millis() - s);
+  return true;
+}
+
+static bool createPresetStore(const char* file)
+{
+  File sf = WLED_FS.open(file, "w");
+  if (!sf) return false;
+  bool ok = sf.print(F(PSTORE_MAGIC)) == 4;
+  sf.close();
+  return ok;
+}
+
+static void abortCompaction()
+{
+  if (!compactId) return;
+  compactSrc.close();
+  compactDst.close();
+  WLED_FS.remove(PSTORE_TMP);
+  compactId = 0;
+}
+
+//appends a preset (or its deletion if content is null) to the store
+static bool writePresetToStore(uint8_t id, JsonDocument* content)
+{
+  if (!presetPos || id == 0 || id > PSTORE_MAX_ID) return false;
+  if (content->isNull() && !presetPos[id]) return true; //nothing to delete
+  abortCompaction(); //it would miss this record, restarted later
+
+  updateFSInfo();
+  if (fsBytesUsed + measureJson(*content) + PSTORE_OVERHEAD + 2*PSTORE_BUFSIZE > fsBytesTotal) {
+    errorFlag = ERR_FS_QUOTA;
+    return false;
+  }
+
+  if (doCloseFile) closeFile();
+  File sf = WLED_FS.open(PSTORE_FILE, "r+");
+  if (!sf) {
+    errorFlag = ERR_FS_GENERAL;
+    return false;
+  }
+  uint8_t oldId; uint16_t oldLen = 0;
+  if (presetPos[id] && !readRecordHeader(sf, presetPos[id], oldId, oldLen)) oldLen = 0;
+
+  uint32_t recLen = sf.seek(presetStoreEnd) ? writePresetRecord(sf, id, content) : 0;
+  sf.close();
+  if (!recLen) {
+    errorFlag = ERR_FS_GENERAL;
+    return false;
+  }
+  if (presetPos[id]) presetStoreDead += PSTORE_OVERHEAD + oldLen;
+  if (recLen > PSTORE_OVERHEAD) {
+    presetPos[id] = presetStoreEnd;
+  } else { //deletion record, dead right away
+    presetPos[id] = 0;
+    presetStoreDead += recLen;
+  }
+  presetStoreEnd += recLen;
+  lastPresetWrite = millis();
+  presetJsonDirty = true;
+  abortPresetsJsonMirror(); //restarted once no preset was saved for a while
+  return true;
+}
+
+static bool readPresetFromStore(uint8_t id, JsonDocument* dest)
+{
+  dest->clear();
+  if (!presetPos || id == 0 || id > PSTORE_MAX_ID || !presetPos[id]) return false;
+  #ifdef WLED_DEBUG_FS
+    DEBUGFS_PRINTF("Read preset %d at %d >>>\n", id, presetPos[id]);
+    uint32_t s = millis();
+  #endif
+  if (doCloseFile) closeFile();
+  File sf = WLED_FS.open(PSTORE_FILE, "r");
+  if (!sf) return false;
+  uint8_t recId; uint16_t len;
+  bool valid = readRecordHeader(sf, presetPos[id], recId, len) && recId == id && len;
+  char* buf = nullptr;
+  if (valid && ESP.getFreeHeap() > len + MIN_HEAP_SIZE) buf = (char*)malloc(len);
+  if (buf) { //a single read of the whole record
+    byte crc[4];
+    valid = sf.read((byte*)buf, len) == len && sf.read(crc, 4) == 4;
+    byte hdr[3] = {id, (byte)(len & 0xFF), (byte)(len >> 8)};
+    uint32_t c = crc32Update(crc32Update(0, hdr, 3), (byte*)buf, len);
+    valid = valid && c == (crc[0] | (crc[1] << 8) | ((uint32_t)crc[2] << 16) | ((uint32_t)crc[3] << 24));
+    if (valid) valid = !deserializeJson(*dest, (const char*)buf, len); //const, so the document copies the strings
+    free(buf);
+  } else if (valid) { //not enough memory, parse from the file
+    valid = !deserializeJson(*dest, sf);
+  }
+  sf.close();
+  DEBUGFS_PRINTF("Read, took %d ms\n", millis() - s);
+  return valid;
+}
+
+//recently applied presets as MessagePack, so playlists, buttons and timers recall them without the filesystem
+#ifdef ESP8266
+#define PRESET_CACHE_SIZE  4
+#define PRESET_CACHE_BYTES 3072
+#else
+#define PRESET_CACHE_SIZE  8
+#define PRESET_CACHE_BYTES 16384
+#endif
+
+static struct {
+  byte* data;       //nullptr if the slot is free
+  uint16_t len;
+  uint8_t id;
+  uint32_t lastUse;
+} presetCache[PRESET_CACHE_SIZE];
+static uint32_t presetCacheBytes = 0;
+static uint32_t presetCacheTick = 0;
+
+static void freePresetCacheSlot(uint8_t i)
+{
+  if (!presetCache[i].data) return;
+  free(presetCache[i].data);
+  presetCache[i].data = nullptr;
+  presetCacheBytes -= presetCache[i].len;
+}
+
+//index 0 drops all presets
+static void invalidatePresetCache(byte index = 0)
+{
+  for (uint8_t i = 0; i < PRESET_CACHE_SIZE; i++) {
+    if (!index || presetCache[i].id == index) freePresetCacheSlot(i);
+  }
+}
+
+static bool readPresetFromCache(byte index, JsonDocument* dest)
+{
+  for (uint8_t i = 0; i < PRESET_CACHE_SIZE; i++) {
+    if (!presetCache[i].data || presetCache[i].id != index) continue;
+    if (deserializeMsgPack(*dest, (const char*)presetCache[i].data, presetCache[i].len)) { //const, so the document copies the strings
+      freePresetCacheSlot(i);
+      return false;
+    }
+    presetCache[i].lastUse = ++presetCacheTick;
+    DEBUGFS_PRINTF("Preset %d from cache\n", index);
+    return true;
+  }
+  return false;
+}
+
+static void cachePreset(byte index, JsonDocument* src)
+{
+  size_t len = measureMsgPack(*src);
+  if (!len || len > PRESET_CACHE_BYTES/2) return; //would push out most of the others
+  uint8_t slot;
+  while (true) { //evict the least recently used until there is a free slot and room
+    uint8_t lru = PRESET_CACHE_SIZE;
+    slot = PRESET_CACHE_SIZE;
+    for (uint8_t i = 0; i < PRESET_CACHE_SIZE; i++) {
+      if (!presetCache[i].data) slot = i;
+      else if (lru == PRESET_CACHE_SIZE || presetCache[i].lastUse < presetCache[lru].lastUse) lru = i;
+    }
+    if (slot < PRESET_CACHE_SIZE && presetCacheBytes + len <= PRESET_CACHE_BYTES) break;
+    if (lru == PRESET_CACHE_SIZE) return;
+    freePresetCacheSlot(lru);
+  }
+  if (ESP.getFreeHeap() < len + MIN_HEAP_SIZE) return;
+  byte* data = (byte*)malloc(len);
+  if (!data) return;
+  serializeMsgPack(*src, data, len);
+  presetCache[slot].data = data;
+  presetCache[slot].len = len;
+  presetCache[slot].id = index;
+  presetCache[slot].lastUse = ++presetCacheTick;
+  presetCacheBytes += len;
+}
+
+static void writePresetsJsonSum(uint32_t size, uint32_t crc)
+{
+  File f = WLED_FS.open(PSTORE_JSON_SUM, "w");
+  if (!f) return;
+  byte sum[8] = {(byte)size, (byte)(size >> 8), (byte)(size >> 16), (byte)(size >> 24),
+                 (byte)crc,  (byte)(crc >> 8),  (byte)(crc >> 16),  (byte)(crc >> 24)};
+  f.write(sum, 8);
+  f.close();
+}
+
+//true if presets.json is the mirror written from the store (or the file imported last)
+static bool presetsJsonIsMirror()
+{
+  File f = WLED_FS.open(PSTORE_JSON_SUM, "r");
+  if (!f) return false;
+  byte sum[8];
+  bool ok = f.read(sum, 8) == 8;
+  f.close();
+  File jf = WLED_FS.open(PSTORE_JSON, "r");
+  if (!ok || !jf) return false;
+  uint32_t size = jf.size(), crc = 0;
+  byte buf[PSTORE_BUFSIZE];
+  size_t n;
+  while ((n = jf.read(buf, PSTORE_BUFSIZE)) > 0) crc = crc32Update(crc, buf, n);
+  jf.close();
+  return size == (sum[0] | (sum[1] << 8) | ((uint32_t)sum[2] << 16) | ((uint32_t)sum[3] << 24))
+      && crc  == (sum[4] | (sum[5] << 8) | ((uint32_t)sum[6] << 16) | ((uint32_t)sum[7] << 24));
+}
+
+//replaces all presets by the ones in presets.json (restored backup or migration from the JSON file).
+//presets.json is kept as the mirror of the new store
+static bool importPresets()
+{
+  DEBUGFS_PRINTLN(F("Import presets.json"));
+  if (doCloseFile) closeFile();
+  File jf = WLED_FS.open(PSTORE_JSON, "r");
+  if (!jf) return false;
+
+  //find the root level objects (string aware), then import them one by one
+  uint32_t* objStart = (uint32_t*)calloc(PSTORE_MAX_ID +1, sizeof(uint32_t));
+  if (!objStart) {
+    jf.close();
+    return false;
+  }
+  byte buf[PSTORE_BUFSIZE];
+  uint32_t pos = 0, start = 0, crc = 0;
+  uint8_t depth = 0;
+  bool inString = false, escaped = false;
+  int key = -1, objId = -1; //numeric value of the last root level key, -1 if not a number
+  size_t bufsize;
+  while ((bufsize = jf.read(buf, PSTORE_BUFSIZE)) > 0) {
+    crc = crc32Update(crc, buf, bufsize);
+    for (size_t i = 0; i < bufsize; i++, pos++) {
+      char c = buf[i];
+      if (inString) {
+        if (escaped) escaped = false;
+        else if (c == '\\') escaped = true;
+        else if (c == '"') inString = false;
+        else if (depth == 1 && key >= 0) key = (isdigit(c) && key < 1000) ? key*10 + (c - '0') : -1;
+        continue;
+      }
+      if (c == '"') {
+        inString = true;
+        if (depth == 1) key = 0;
+      } else if (c == '{') {
+        if (++depth == 2) {
+          start = pos;
+          objId = key;
+        }
+      } else if (c == '}' && depth) {
+        if (--depth == 1 && objId > 0 && objId <= PSTORE_MAX_ID && !objStart[objId]) objStart[objId] = start;
+      }
+    }
+  }
+
+  #ifdef WLED_USE_DYNAMIC_JSON
+  DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+  #else
+  if (!requestJSONBufferLock(22)) {
+    free(objStart);
+    jf.close();
+    return false;
+  }
+  #endif
+  abortCompaction();
+  bool ok = createPresetStore(PSTORE_TMP);
+  File sf = WLED_FS.open(PSTORE_TMP, "r+");
+  ok = ok && sf && sf.seek(4);
+  for (uint8_t id = 1; ok && id <= PSTORE_MAX_ID; id++) {
+    if (!objStart[id]) continue;
+    jf.seek(objStart[id]);
+    if (deserializeJson(doc, jf)) continue; //skip broken presets
+    ok = writePresetRecord(sf, id, &doc);
+  }
+  releaseJSONBufferLock();
+  free(objStart);
+  sf.close();
+  jf.close();
+
+  if (ok) {
+    WLED_FS.remove(PSTORE_FILE);
+    ok = WLED_FS.rename(PSTORE_TMP, PSTORE_FILE);
+  }
+  if (ok) { //not removed, so a downgrade still finds the presets
+    writePresetsJsonSum(pos, crc);
+    presetJsonDirty = false;
+  } else {
+    WLED_FS.remove(PSTORE_TMP);
+  }
+  scanPresetStore();
+  invalidatePresetCache();
+  presetsModifiedTime = toki.second(); //unix time
+  updateFSInfo();
+  return ok;
+}
+
+//loads the store at boot, importing presets.json unless it is the mirror of the store
+//(previous versions, changed after a downgrade or restored before reboot)
+void initPresetStore()
+{
+  if (!presetPos) presetPos = (uint32_t*)calloc(PSTORE_MAX_ID +1, sizeof(uint32_t));
+  if (!presetPos) return; //presets unavailable
+
+  if (WLED_FS.exists(PSTORE_TMP)) { //compaction was interrupted
+    if (WLED_FS.exists(PSTORE_FILE)) WLED_FS.remove(PSTORE_TMP);
+    else WLED_FS.rename(PSTORE_TMP, PSTORE_FILE); //... after the old store was removed
+  }
+  bool json = WLED_FS.exists(PSTORE_JSON);
+  if (json && !presetsJsonIsMirror() && importPresets()) return;
+  if (scanPresetStore()) {
+    presetJsonDirty = !json; //e.g. removed by an earlier version of the store
+    return;
+  }
+  if (json && importPresets()) return; //store lost, the mirror still has the presets
+  if (createPresetStore(PSTORE_FILE)) presetStoreEnd = 4;
+}
+
+//one compaction step: start, copy one preset or replace the store
+static void compactPresetStore()
+{
+  if (!compactId) {
+    if (presetStoreDead < PSTORE_COMPACT_MIN || millis() - lastPresetWrite < PSTORE_COMPACT_DELAY) return;
+    updateFSInfo();
+    if (fsBytesUsed + (presetStoreEnd - presetStoreDead) + 2*PSTORE_BUFSIZE > fsBytesTotal) return; //no room for the live records
+    DEBUGFS_PRINTLN(F("Compact preset store"));
+    if (!createPresetStore(PSTORE_TMP)) return;
+    compactSrc = WLED_FS.open(PSTORE_FILE, "r");
+    compactDst = WLED_FS.open(PSTORE_TMP, "r+");
+    compactId = 1;
+    if (!compactSrc || !compactDst || !compactDst.seek(4)) {
+      abortCompaction();
+      lastPresetWrite = millis(); //retry later
+    }
+    return;
+  }
+
+  while (compactId <= PSTORE_MAX_ID && !presetPos[compactId]) compactId++;
+  if (compactId <= PSTORE_MAX_ID) { //copy the record as is
+    uint8_t id; uint16_t len;
+    bool ok = readRecordHeader(compactSrc, presetPos[compactId], id, len) && compactSrc.seek(presetPos[compactId]);
+    uint32_t left = ok ? len + PSTORE_OVERHEAD : 0;
+    byte buf[PSTORE_BUFSIZE];
+    while (ok && left) {
+      size_t n = compactSrc.read(buf, left < PSTORE_BUFSIZE ? left : PSTORE_BUFSIZE);
+      ok = n && compactDst.write(buf, n) == n;
+      left -= n;
+    }
+    if (!ok) {
+      abortCompaction();
+      lastPresetWrite = millis(); //retry later
+      return;
+    }
+    compactId++;
+    return;
+  }
+
+  //all live records copied, replace the store
+  compactSrc.close();
+  compactDst.close();
+  compactId = 0;
+  WLED_FS.remove(PSTORE_FILE);
+  WLED_FS.rename(PSTORE_TMP, PSTORE_FILE);
+  scanPresetStore();
+  updateFSInfo();
+  DEBUGFS_PRINTLN(F("Compacted"));
+}
+
+static void mirrorPresetsJson();
+
+//background work from the main loop: import of an uploaded presets.json, compaction and the presets.json mirror.
+//Import and compaction wait for running exports (the mirror is one as well)
+void handlePresetStore()
+{
+  if (!presetPos) return;
+  if (doImportPresets) abortPresetsJsonMirror(); //the upload replaced presets.json
+  if (jsonMirror) {
+    mirrorPresetsJson();
+    return;
+  }
+  if (!lockPresetStore()) return;
+  if (doImportPresets) {
+    doImportPresets = false;
+    importPresets();
+  } else {
+    compactPresetStore();
+  }
+  unlockPresetStore();
+  if (!compactId) mirrorPresetsJson();
+}
+
+//presets.json as it used to be stored, generated from the store
+class PresetExporter {
+  public:
+    PresetExporter() {
+      PSTORE_ENTER;
+      _ready = !presetStoreBusy;
+      if (_ready) presetStoreReaders++;
+      PSTORE_EXIT;
+      if (_ready) _sf = WLED_FS.open(PSTORE_FILE, "r");
+    }
+    ~PresetExporter() {
+      if (_sf) _sf.close();
+      if (!_ready) return;
+      PSTORE_ENTER;
+      presetStoreReaders--;
+      PSTORE_EXIT;
+    }
+
+    bool ready() { return _ready; }
+    bool done() { return _done; }
+
+    size_t fill(uint8_t *buffer, size_t maxLen) {
+      size_t n = 0;
+      while (n < maxLen && !_done) {
+        if (_left) { //rest of the current preset
+          size_t r = _sf.read(buffer + n, _left < maxLen - n ? _left : maxLen - n);
+          if (!r) return n; //read error, the JSON stays incomplete
+          _left -= r;
+          n += r;
+          continue;
+        }
+        if (maxLen - n < 8) break; //room for the next key
+        if (!_id) { //dummy object "0", see file.cpp
+          n += sprintf_P((char*)buffer + n, PSTR("{\"0\":{}"));
+          _id = 1;
+          continue;
+        }
+        while (_id <= PSTORE_MAX_ID && (!presetPos || !presetPos[_id])) _id++;
+        if (_id > PSTORE_MAX_ID) {
+          buffer[n++] = '}';
+          _done = true;
+          break;
+        }
+        uint8_t id; uint16_t len;
+        if (_sf && readRecordHeader(_sf, presetPos[_id], id, len) && id == _id && len) {
+          n += sprintf_P((char*)buffer + n, PSTR(",\"%d\":"), _id);
+          _left = len;
+        }
+        _id++;
+      }
+      return n;
+    }
+
+  private:
+    File _sf;
+    uint16_t _left = 0;
+    uint16_t _id = 0;
+    bool _done = false;
+    bool _ready = false;
+};
+
+static void abortPresetsJsonMirror()
+{
+  if (!jsonMirror) return;
+  delete jsonMirror;
+  jsonMirror = nullptr;
+  jsonMirrorFile.close();
+  WLED_FS.remove(PSTORE_JSON_TMP);
+}
+
+//one step of rewriting the presets.json mirror: start, export a block of the store or replace presets.json
+static void mirrorPresetsJson()
+{
+  if (!jsonMirror) {
+    if (!presetJsonDirty || millis() - lastPresetWrite < PSTORE_COMPACT_DELAY) return;
+    updateFSInfo();
+    if (fsBytesUsed + (presetStoreEnd - presetStoreDead) + 2*PSTORE_BUFSIZE > fsBytesTotal) { //no room for a second copy
+      lastPresetWrite = millis(); //retry later
+      return;
+    }
+    DEBUGFS_PRINTLN(F("Mirror presets.json"));
+    jsonMirror = new PresetExporter();
+    jsonMirrorFile = WLED_FS.open(PSTORE_JSON_TMP, "w");
+    jsonMirrorSize = jsonMirrorCrc = 0;
+    if (!jsonMirror->ready() || !jsonMirrorFile) {
+      abortPresetsJsonMirror();
+      lastPresetWrite = millis(); //retry later
+    }
+    return;
+  }
+
+  byte buf[PSTORE_BUFSIZE];
+  size_t n = jsonMirror->fill(buf, PSTORE_BUFSIZE);
+  if (n) {
+    if (jsonMirrorFile.write(buf, n) != n) {
+      abortPresetsJsonMirror();
+      lastPresetWrite = millis(); //retry later
+      return;
+    }
+    jsonMirrorCrc = crc32Update(jsonMirrorCrc, buf, n);
+    jsonMirrorSize += n;
+    return;
+  }
+  bool ok = jsonMirror->done(); //otherwise the store could not be read
+  jsonMirrorFile.close();
+  delete jsonMirror;
+  jsonMirror = nullptr;
+  if (ok) {
+    WLED_FS.remove(PSTORE_JSON_SUM); //an interrupted swap imports the mirror at boot, which is harmless
+    WLED_FS.remove(PSTORE_JSON);
+    ok = WLED_FS.rename(PSTORE_JSON_TMP, PSTORE_JSON);
+  }
+  if (ok) {
+    writePresetsJsonSum(jsonMirrorSize, jsonMirrorCrc);
+    presetJsonDirty = false;
+  } else {
+    WLED_FS.remove(PSTORE_JSON_TMP);
+    lastPresetWrite = millis(); //retry later
+  }
+  updateFSInfo();
+  DEBUGFS_PRINTLN(F("Mirrored"));
+}
+
+void servePresetsJson(AsyncWebServerRequest* request)
+{
+  std::shared_ptr<PresetExporter> exporter = std::make_shared<PresetExporter>();
+  if (!exporter->ready()) { //store is being imported or compacted right now
+    request->send(503, "application/json", F("{\"error\":\"Busy\"}"));
+    return;
+  }
+  AsyncWebServerResponse *response = request->beginChunkedResponse(request->hasArg(F("download")) ? "application/octet-stream" : "application/json",
+    [exporter](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      return exporter->fill(buffer, maxLen);
+    });
+  request->send(response);
+}
+
+static bool loadPreset(byte index, JsonDocument* dest)
+{
+  if (readPresetFromCache(index, dest)) return true;
+  bool loaded = (index < 255) ? readPresetFromStore(index, dest) : readObjectFromFileUsingId("/tmp.json", index, dest);
+  if (loaded) cachePreset(index, dest); //only cleanly parsed presets, a partial document would be recalled as is
+  return loaded;
+}
+
+//for requests from async callbacks: {"<key>":index[,"n":pname]} is applied by handleJsonCommands() instead
+static bool queuePresetCommand(const char* key, byte index, const char* pname = nullptr)
+{
+  StaticJsonDocument<JSON_OBJECT_SIZE(2)> cmd;
+  cmd[key] = index;
+  if (pname) cmd["n"] = pname; //const char*, not copied
+  String json;
+  serializeJson(cmd, json);
+  return queueJsonCommand(json.c_str(), json.length());
+}
+
+static bool storePreset(byte index, JsonDocument* content)
+{
+  invalidatePresetCache(index);
+  if (index < 255) return writePresetToStore(index, content);
+  return writeObjectToFileUsingId("/tmp.json", index, content);
+}
+
 bool applyPreset(byte index, byte callMode)
 {
   if (index == 0) return false;
-
-  const char *filename = index < 255 ? "/presets.json" : "/tmp.json";
+  if (!inLoopContext()) return queuePresetCommand("ps", index); //e.g. Alexa
 
 	uint8_t core = 1;
 	//crude way to determine if this was called by a network request
@@ -19,7 +767,7 @@ bool applyPreset(byte index, byte callMode)
 	//only allow use of fileDoc from the core responsible for network requests
 	//do not use active network request doc from preset called by main loop (playlist, schedule, ...)
   if (fileDoc && core) {
-    errorFlag = readObjectFromFileUsingId(filename, index, fileDoc) ? ERR_NONE : ERR_FS_PLOAD;
+    errorFlag = loadPreset(index, fileDoc) ? ERR_NONE : ERR_FS_PLOAD;
     JsonObject fdo = fileDoc->as<JsonObject>();
     if (fdo["ps"] == index) fdo.remove("ps"); //remove load request for same presets to prevent recursive crash
     #ifdef WLED_DEBUG_FS
@@ -33,7 +781,7 @@ bool applyPreset(byte index, byte callMode)
     #else
     if (!requestJSONBufferLock(9)) return false;
     #endif
-    errorFlag = readObjectFromFileUsingId(filename, index, &doc) ? ERR_NONE : ERR_FS_PLOAD;
+    errorFlag = loadPreset(index, &doc) ? ERR_NONE : ERR_FS_PLOAD;
     JsonObject fdo = doc.as<JsonObject>();
     if (fdo["ps"] == index) fdo.remove("ps");
     #ifdef WLED_DEBUG_FS
@@ -53,10 +801,12 @@ bool applyPreset(byte index, byte callMode)
 void savePreset(byte index, bool persist, const char* pname, JsonObject saveobj)
 {
   if (index == 0 || (index > 250 && persist) || (index<255 && !persist)) return;
+  if (persist && !inLoopContext()) {
+    queuePresetCommand("psave", index, pname);
+    return;
+  }
   JsonObject sObj = saveobj;
 
-  const char *filename = persist ? "/presets.json" : "/tmp.json";
-
   if (!fileDoc) {
     DEBUGFS_PRINTLN(F("Allocating saving buffer"));
     #ifdef WLED_USE_DYNAMIC_JSON
@@ -71,7 +821,7 @@ void savePreset(byte index, bool persist, const char* pname, JsonObject saveobj)
     serializeState(sObj, true);
     if (persist) currentPreset = index;
 
-    writeObjectToFileUsingId(filename, index, &doc);
+    storePreset(index, &doc);
 
     releaseJSONBufferLock();
   } else { //from JSON API (fileDoc != nullptr)
@@ -90,15 +840,19 @@ void savePreset(byte index, bool persist, const char* pname, JsonObject saveobj)
     sObj.remove(F("error"));
     sObj.remove(F("time"));
 
-    writeObjectToFileUsingId(filename, index, fileDoc);
+    storePreset(index, fileDoc);
   }
   if (persist) presetsModifiedTime = toki.second(); //unix time
   updateFSInfo();
 }
 
 void deletePreset(byte index) {
+  if (!inLoopContext()) {
+    queuePresetCommand("pdel", index);
+    return;
+  }
   StaticJsonDocument<24> empty;
-  writeObjectToFileUsingId("/presets.json", index, &empty);
+  storePreset(index, &empty);
   presetsModifiedTime = toki.second(); //unix time
   updateFSInfo();
 }
\ No newline at end of file
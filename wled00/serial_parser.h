@@ -0,0 +1,137 @@
+#ifndef WLED_SERIAL_PARSER_H
+#define WLED_SERIAL_PARSER_H
+/*
+ * Adalight and TPM2 frame parser
+ * Pure state machine over a byte buffer, so it does not depend on Serial or the strip (see test/test_serial_parser).
+ * Header bytes are consumed one at a time, pixel data in blocks of up to dataLeft() bytes.
+ * Bytes that are neither part of a frame nor of a header are reported as commands and not consumed,
+ * the caller decides whether to read the command from its stream or to discard the byte.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+class SerialFrameParser {
+  public:
+    enum : uint8_t { SP_NONE, SP_FRAME, SP_COMMAND, SP_TPM2_PING };
+
+    ~SerialFrameParser() { freeBuffer(); }
+
+    //pixel data bytes stored per frame, data beyond is received but not stored
+    void setCapacity(uint32_t bytes) { _capacity = bytes; }
+
+    //waiting for a frame header, other bytes are commands
+    bool idle() { return _state == ST_IDLE; }
+
+    //pixel data bytes missing to complete the frame being received
+    uint32_t dataLeft() { return (_state == ST_DATA) ? _frameLen - _received : 0; }
+
+    //pixel data of the last complete frame, 3 bytes per LED, valid until the next header is parsed
+    const uint8_t* frame() { return _frame; }
+    uint16_t frameLeds() { return _stored / 3; }
+
+    void freeBuffer() {
+      free(_frame);
+      _frame = nullptr;
+      _size = _stored = 0;
+    }
+
+    //parses up to len bytes and stops after an event, returns the number of bytes consumed (0 for a command)
+    size_t parse(const uint8_t* data, size_t len, uint8_t& event) {
+      event = SP_NONE;
+      size_t n = 0;
+      while (n < len && event == SP_NONE) {
+        if (_state == ST_DATA) { //block copy
+          uint32_t c = len - n;
+          if (c > _frameLen - _received) c = _frameLen - _received;
+          if (_received < _stored) memcpy(_frame + _received, data + n, (c < _stored - _received) ? c : _stored - _received);
+          _received += c;
+          n += c;
+          if (_received == _frameLen) {
+            _state = ST_IDLE;
+            event = SP_FRAME;
+          }
+          continue;
+        }
+        uint8_t b = data[n];
+        switch (_state) {
+          case ST_IDLE:
+            if      (b == 'A')  _state = ST_ADA_D;
+            else if (b == 0xC9) _state = ST_TPM2_TYPE; //TPM2 start byte
+            else {
+              _command = b;
+              event = SP_COMMAND;
+              return n;
+            }
+            break;
+          case ST_ADA_D:
+            _state = (b == 'd') ? ST_ADA_A : ST_IDLE;
+            break;
+          case ST_ADA_A:
+            _state = (b == 'a') ? ST_ADA_COUNT_HI : ST_IDLE;
+            break;
+          case ST_ADA_COUNT_HI:
+            _frameLen = b * 0x100;
+            _check = b;
+            _state = ST_ADA_COUNT_LO;
+            break;
+          case ST_ADA_COUNT_LO:
+            _frameLen = (_frameLen + b + 1) * 3; //LED count - 1
+            _check = _check ^ b ^ 0x55;
+            _state = ST_ADA_CHECK;
+            break;
+          case ST_ADA_CHECK:
+            _state = ST_IDLE;
+            if (_check == b) startFrame(_frameLen);
+            break;
+          case ST_TPM2_TYPE:
+            _state = ST_IDLE; //(unsupported) TPM2 command or invalid type
+            if      (b == 0xDA) _state = ST_TPM2_COUNT_HI; //TPM2 data
+            else if (b == 0xAA) event = SP_TPM2_PING;
+            break;
+          case ST_TPM2_COUNT_HI:
+            _frameLen = b * 0x100;
+            _state = ST_TPM2_COUNT_LO;
+            break;
+          case ST_TPM2_COUNT_LO:
+            _frameLen += b; //data length in bytes, the 0x36 end byte that follows is a command byte to discard
+            _state = ST_IDLE;
+            if (_frameLen) startFrame(_frameLen - _frameLen % 3);
+            break;
+        }
+        n++;
+      }
+      return n;
+    }
+
+    //byte reported by the last SP_COMMAND event
+    uint8_t command() { return _command; }
+
+  private:
+    enum : uint8_t { ST_IDLE, ST_ADA_D, ST_ADA_A, ST_ADA_COUNT_HI, ST_ADA_COUNT_LO, ST_ADA_CHECK,
+                     ST_TPM2_TYPE, ST_TPM2_COUNT_HI, ST_TPM2_COUNT_LO, ST_DATA };
+    uint8_t  _state = ST_IDLE;
+    uint8_t  _check = 0;
+    uint8_t  _command = 0;
+    uint32_t _frameLen = 0;  //bytes of pixel data in the frame
+    uint32_t _received = 0;  //bytes of pixel data received so far
+    uint32_t _stored = 0;    //bytes of pixel data that fit into _frame
+    uint32_t _size = 0;      //allocated size of _frame
+    uint32_t _capacity = 0;
+    uint8_t* _frame = nullptr;
+
+    //makes room for the pixel data (store bytes of frameLen are kept)
+    void startFrame(uint32_t store) {
+      if (store > _capacity) store = _capacity;
+      if (store > _size) {
+        free(_frame);
+        _frame = (uint8_t*)malloc(store);
+        _size = _frame ? store : 0;
+      }
+      _stored = (store < _size) ? store : _size;
+      _received = 0;
+      _state = ST_DATA;
+    }
+};
+
+#endif
@@ -27,12 +27,12 @@ bool isAsterisksOnly(const char* str, byte maxLen)
 }
 
 
-//called upon POST settings form submit
-void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
+//called upon POST settings form submit, returns false if the settings could not be applied (busy)
+bool handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
 {
 
   //0: menu 1: wifi 2: leds 3: ui 4: sync 5: time 6: sec 7: DMX 8: usermods
-  if (subPage <1 || subPage >8) return;
+  if (subPage <1 || subPage >8) return true;
 
   //WIFI SETTINGS
   if (subPage == 1)
@@ -133,6 +133,9 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
       // actual finalization is done in WLED::loop() (removing old busses and adding new)
       if (busConfigs[s] != nullptr) delete busConfigs[s];
       busConfigs[s] = new BusConfig(type, pins, start, length, colorOrder, request->hasArg(cv), skip);
+      // output universe of network busses is only configurable in cfg.json, keep it
+      Bus* bus = busses.getBus(s);
+      if (bus && bus->getType() == busConfigs[s]->type) busConfigs[s]->universe = bus->getUniverse();
       doInitBusses = true;
     }
 
@@ -460,15 +463,15 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
   //USERMODS
   if (subPage == 8)
   {
-    #ifdef WLED_USE_DYNAMIC_JSON
-    DynamicJsonDocument doc(JSON_BUFFER_SIZE);
-    #else
-    if (!requestJSONBufferLock(5)) return;
-    #endif
+    //usermod settings are applied by the main loop like a POST to /json/cfg, the JSON buffer may be in use there.
+    //Each argument adds at most a usermod object, a nested object and a value, plus copies of its strings
+    size_t args = request->args();
+    size_t docSize = JSON_OBJECT_SIZE(1);
+    for (size_t i=0; i<args; i++) docSize += JSON_OBJECT_SIZE(3) + request->argName(i).length() + request->arg(i).length() +3;
+    DynamicJsonDocument doc(docSize);
 
     JsonObject um = doc.createNestedObject("um");
 
-    size_t args = request->args();
     uint j=0;
     for (size_t i=0; i<args; i++) {
       String name = request->argName(i);
@@ -537,23 +540,109 @@ void handleSettingsSet(AsyncWebServerRequest *request, byte subPage)
         DEBUG_PRINTLN(value);
       }
     }
-    usermods.readFromConfig(um);  // force change of usermod parameters
-
-    releaseJSONBufferLock();
+    if (doc.overflowed()) return false;
+    size_t len = measureJson(doc);
+    char* json = (char*)malloc(len +1);
+    if (!json) return false;
+    serializeJson(doc, json, len +1);
+    bool queued = queueJsonCommand(json, len, JSON_CMD_CFG); // force change of usermod parameters, saved once applied
+    free(json);
+    return queued;
   }
   
-  if (subPage != 2 && (subPage != 6 || !doReboot)) serializeConfig(); //do not save if factory reset or LED settings (which are saved after LED re-init)
+  if (subPage != 2 && (subPage != 6 || !doReboot)) doSerializeConfig = true; //do not save if factory reset or LED settings (which are saved after LED re-init)
   if (subPage == 4) alexaInit();
+  return true;
 }
 
 
 
-//helper to get int value at a position in string
-int getNumVal(const String* req, uint16_t pos)
+//HTTP API keys have one or two characters, packed into 16 bits they are their own perfect hash
+#define API_KEY(a,b) (((uint16_t)(a) << 8) | (uint8_t)(b))
+
+//all HTTP API keys, sorted so that request tokens can be looked up by binary search.
+//The position of a key is its ApiParam, both lists must be kept in the same order!
+static constexpr uint16_t apiKeys[] PROGMEM = {
+  API_KEY('A',0),   API_KEY('B',0),   API_KEY('B','2'), API_KEY('C','2'), API_KEY('C','3'), API_KEY('C','L'),
+  API_KEY('C','T'), API_KEY('F','P'), API_KEY('F','X'), API_KEY('G',0),   API_KEY('G','2'), API_KEY('G','P'),
+  API_KEY('H','2'), API_KEY('H','U'), API_KEY('I','N'), API_KEY('I','X'), API_KEY('K',0),   API_KEY('K','2'),
+  API_KEY('L','O'), API_KEY('L','X'), API_KEY('L','Y'), API_KEY('M',0),   API_KEY('M','I'), API_KEY('N','B'),
+  API_KEY('N','D'), API_KEY('N','F'), API_KEY('N','L'), API_KEY('N','M'), API_KEY('N','N'), API_KEY('N','T'),
+  API_KEY('N','X'), API_KEY('O','L'), API_KEY('P','1'), API_KEY('P','2'), API_KEY('P','L'), API_KEY('P','S'),
+  API_KEY('R',0),   API_KEY('R','2'), API_KEY('R','B'), API_KEY('R','D'), API_KEY('R','N'), API_KEY('R','V'),
+  API_KEY('S',0),   API_KEY('S','2'), API_KEY('S','A'), API_KEY('S','B'), API_KEY('S','C'), API_KEY('S','M'),
+  API_KEY('S','N'), API_KEY('S','P'), API_KEY('S','R'), API_KEY('S','S'), API_KEY('S','T'), API_KEY('S','V'),
+  API_KEY('S','W'), API_KEY('S','X'), API_KEY('T',0),   API_KEY('T','T'), API_KEY('T','X'), API_KEY('U','0'),
+  API_KEY('U','1'), API_KEY('W',0),   API_KEY('W','2')
+};
+
+enum ApiParam : uint8_t {
+  AP_A,  AP_B,  AP_B2, AP_C2, AP_C3, AP_CL,
+  AP_CT, AP_FP, AP_FX, AP_G,  AP_G2, AP_GP,
+  AP_H2, AP_HU, AP_IN, AP_IX, AP_K,  AP_K2,
+  AP_LO, AP_LX, AP_LY, AP_M,  AP_MI, AP_NB,
+  AP_ND, AP_NF, AP_NL, AP_NM, AP_NN, AP_NT,
+  AP_NX, AP_OL, AP_P1, AP_P2, AP_PL, AP_PS,
+  AP_R,  AP_R2, AP_RB, AP_RD, AP_RN, AP_RV,
+  AP_S,  AP_S2, AP_SA, AP_SB, AP_SC, AP_SM,
+  AP_SN, AP_SP, AP_SR, AP_SS, AP_ST, AP_SV,
+  AP_SW, AP_SX, AP_T,  AP_TT, AP_TX, AP_U0,
+  AP_U1, AP_W,  AP_W2,
+  AP_COUNT
+};
+
+static constexpr bool apiKeysSorted(uint8_t i = 1)
+{
+  return i >= AP_COUNT || (apiKeys[i-1] < apiKeys[i] && apiKeysSorted(i+1));
+}
+static_assert(sizeof(apiKeys)/sizeof(apiKeys[0]) == AP_COUNT, "apiKeys and ApiParam differ in length");
+static_assert(apiKeysSorted(), "apiKeys must be sorted ascending");
+
+static int8_t apiParamIndex(uint16_t key)
 {
-  return req->substring(pos+3).toInt();
+  uint8_t lo = 0, hi = AP_COUNT;
+  while (lo < hi) {
+    uint8_t mid = (lo + hi) >> 1;
+    uint16_t k = pgm_read_word(&apiKeys[mid]);
+    if (k == key) return mid;
+    if (k < key) lo = mid +1;
+    else         hi = mid;
+  }
+  return -1;
+}
+
+static_assert(AP_COUNT <= 64, "ApiParam does not fit the key mask");
+
+//splits an API request into its parameters in a single pass without copying anything.
+//val[p] points to the value of ApiParam p (after the '='), or is nullptr if the request does not contain it
+//with a value. The first occurrence of a key with a value is used.
+//Returns a mask of all keys present (bit p), including flags without value like "&RB", see apiHas()
+static uint64_t tokenizeApiRequest(const char* req, const char** val)
+{
+  uint64_t keys = 0;
+  memset(val, 0, sizeof(const char*) * AP_COUNT);
+  const char* p = req;
+  while (*p) {
+    const char* key = p;
+    while (*p && *p != '=' && *p != '&' && *p != '?') p++;
+    uint8_t keyLen = p - key;
+    if (keyLen == 1 || keyLen == 2) {
+      int8_t i = apiParamIndex(API_KEY(key[0], keyLen == 2 ? key[1] : 0));
+      if (i >= 0) {
+        keys |= 1ULL << i;
+        if (*p == '=' && !val[i]) val[i] = p +1;
+      }
+    }
+    while (*p && *p != '&' && *p != '?') p++; //skip value
+    if (*p) p++;
+  }
+  return keys;
 }
 
+static inline bool apiHas(uint64_t keys, ApiParam p)
+{
+  return keys & (1ULL << p);
+}
 
 //helper to get int value with in/decrementing support via ~ syntax
 void parseNumber(const char* str, byte* val, byte minv, byte maxv)
@@ -593,32 +682,37 @@ void parseNumber(const char* str, byte* val, byte minv, byte maxv)
 }
 
 
-bool updateVal(const String* req, const char* key, byte* val, byte minv, byte maxv)
+bool updateVal(const char* str, byte* val, byte minv, byte maxv)
 {
-  int pos = req->indexOf(key);
-  if (pos < 1) return false;
-  if (req->length() < (unsigned int)(pos + 4)) return false;
-  parseNumber(req->c_str() + pos +3, val, minv, maxv);
+  if (str == nullptr || str[0] == '\0') return false;
+  parseNumber(str, val, minv, maxv);
   return true;
 }
 
 
-//HTTP API request parser
-bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
+//HTTP API request parser, the request is tokenized in place (no copy)
+//fromWeb: queued request of the web server (request is nullptr when applied from the main loop)
+bool handleSet(AsyncWebServerRequest *request, const char* req, bool apply, bool fromWeb)
 {
-  if (!(req.indexOf("win") >= 0)) return false;
+  if (!strstr(req, "win")) return false;
 
-  int pos = 0;
   DEBUG_PRINT(F("API req: "));
   DEBUG_PRINTLN(req);
 
+  const char* v[AP_COUNT];
+  uint64_t keys = tokenizeApiRequest(req, v);
+
+  //stage all changes of this request, TX=1 keeps staging for further requests until TX=0
+  bool commitTx = !strip.inTransaction() || (v[AP_TX] && v[AP_TX][0] == '0');
+  if (v[AP_TX] && v[AP_TX][0] == '1') commitTx = false;
+  strip.beginTransaction();
+
   strip.applyToAllSelected = true;
 
   //segment select (sets main segment)
   byte prevMain = strip.getMainSegmentId();
-  pos = req.indexOf(F("SM="));
-  if (pos > 0) {
-    strip.mainSegment = getNumVal(&req, pos);
+  if (v[AP_SM]) {
+    strip.mainSegment = atoi(v[AP_SM]);
   }
   byte selectedSeg = strip.getMainSegmentId();
   if (selectedSeg != prevMain) setValuesFromMainSeg();
@@ -631,9 +725,8 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   byte prevIntensity = effectIntensity;
   byte prevPalette   = effectPalette;
 
-  pos = req.indexOf(F("SS="));
-  if (pos > 0) {
-    byte t = getNumVal(&req, pos);
+  if (v[AP_SS]) {
+    byte t = atoi(v[AP_SS]);
     if (t < strip.getMaxSegments()) {
       selectedSeg = t;
       strip.applyToAllSelected = false;
@@ -641,9 +734,8 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   }
 
   WS2812FX::Segment& selseg = strip.getSegment(selectedSeg);
-  pos = req.indexOf(F("SV=")); //segment selected
-  if (pos > 0) {
-    byte t = getNumVal(&req, pos);
+  if (v[AP_SV]) { //segment selected
+    byte t = atoi(v[AP_SV]);
     if (t == 2) for (uint8_t i = 0; i < strip.getMaxSegments(); i++) strip.getSegment(i).setOption(SEG_OPTION_SELECTED, 0); // unselect other segments
     selseg.setOption(SEG_OPTION_SELECTED, t);
   }
@@ -652,93 +744,80 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   uint16_t stopI  = selseg.stop;
   uint8_t  grpI   = selseg.grouping;
   uint16_t spcI   = selseg.spacing;
-  pos = req.indexOf(F("&S=")); //segment start
-  if (pos > 0) {
-    startI = getNumVal(&req, pos);
+  if (v[AP_S]) { //segment start
+    startI = atoi(v[AP_S]);
   }
-  pos = req.indexOf(F("S2=")); //segment stop
-  if (pos > 0) {
-    stopI = getNumVal(&req, pos);
+  if (v[AP_S2]) { //segment stop
+    stopI = atoi(v[AP_S2]);
   }
-  pos = req.indexOf(F("GP=")); //segment grouping
-  if (pos > 0) {
-    grpI = getNumVal(&req, pos);
+  if (v[AP_GP]) { //segment grouping
+    grpI = atoi(v[AP_GP]);
     if (grpI == 0) grpI = 1;
   }
-  pos = req.indexOf(F("SP=")); //segment spacing
-  if (pos > 0) {
-    spcI = getNumVal(&req, pos);
+  if (v[AP_SP]) { //segment spacing
+    spcI = atoi(v[AP_SP]);
   }
   strip.setSegment(selectedSeg, startI, stopI, grpI, spcI);
 
-  pos = req.indexOf(F("RV=")); //Segment reverse
-  if (pos > 0) selseg.setOption(SEG_OPTION_REVERSED, req.charAt(pos+3) != '0');
+  if (v[AP_RV]) selseg.setOption(SEG_OPTION_REVERSED, v[AP_RV][0] != '0'); //Segment reverse
 
-  pos = req.indexOf(F("MI=")); //Segment mirror
-  if (pos > 0) selseg.setOption(SEG_OPTION_MIRROR, req.charAt(pos+3) != '0');
+  if (v[AP_MI]) selseg.setOption(SEG_OPTION_MIRROR, v[AP_MI][0] != '0'); //Segment mirror
 
-  pos = req.indexOf(F("SB=")); //Segment brightness/opacity
-  if (pos > 0) {
-    byte segbri = getNumVal(&req, pos);
+  if (v[AP_SB]) { //Segment brightness/opacity
+    byte segbri = atoi(v[AP_SB]);
     selseg.setOption(SEG_OPTION_ON, segbri, selectedSeg);
     if (segbri) {
       selseg.setOpacity(segbri, selectedSeg);
     }
   }
 
-  pos = req.indexOf(F("SW=")); //segment power
-  if (pos > 0) {
-    switch (getNumVal(&req, pos)) {
+  if (v[AP_SW]) { //segment power
+    switch (atoi(v[AP_SW])) {
       case 0: selseg.setOption(SEG_OPTION_ON, false); break;
       case 1: selseg.setOption(SEG_OPTION_ON, true); break;
       default: selseg.setOption(SEG_OPTION_ON, !selseg.getOption(SEG_OPTION_ON)); break;
     }
   }
 
-  pos = req.indexOf(F("PS=")); //saves current in preset
-  if (pos > 0) savePreset(getNumVal(&req, pos));
+  if (v[AP_PS]) savePreset(atoi(v[AP_PS])); //saves current in preset
 
-  pos = req.indexOf(F("P1=")); //sets first preset for cycle
-  if (pos > 0) presetCycMin = getNumVal(&req, pos);
+  if (v[AP_P1]) presetCycMin = atoi(v[AP_P1]); //sets first preset for cycle
 
-  pos = req.indexOf(F("P2=")); //sets last preset for cycle
-  if (pos > 0) presetCycMax = getNumVal(&req, pos);
+  if (v[AP_P2]) presetCycMax = atoi(v[AP_P2]); //sets last preset for cycle
 
   //apply preset
-  if (updateVal(&req, "PL=", &presetCycCurr, presetCycMin, presetCycMax)) {
+  if (updateVal(v[AP_PL], &presetCycCurr, presetCycMin, presetCycMax)) {
 		unloadPlaylist();
     applyPreset(presetCycCurr);
   }
 
   //set brightness
-  updateVal(&req, "&A=", &bri);
+  updateVal(v[AP_A], &bri);
 
   bool col0Changed = false, col1Changed = false, col2Changed = false;
   //set colors
-  updateVal(&req, "&R=", &col[0]);
-  updateVal(&req, "&G=", &col[1]);
-  updateVal(&req, "&B=", &col[2]);
-  updateVal(&req, "&W=", &col[3]);
+  updateVal(v[AP_R], &col[0]);
+  updateVal(v[AP_G], &col[1]);
+  updateVal(v[AP_B], &col[2]);
+  updateVal(v[AP_W], &col[3]);
   for (byte i=0; i<4; i++) if (prevCol[i]!=col[i]) col0Changed = colorChanged = true;
-  updateVal(&req, "R2=", &colSec[0]);
-  updateVal(&req, "G2=", &colSec[1]);
-  updateVal(&req, "B2=", &colSec[2]);
-  updateVal(&req, "W2=", &colSec[3]);
+  updateVal(v[AP_R2], &colSec[0]);
+  updateVal(v[AP_G2], &colSec[1]);
+  updateVal(v[AP_B2], &colSec[2]);
+  updateVal(v[AP_W2], &colSec[3]);
   for (byte i=0; i<4; i++) if (prevColSec[i]!=colSec[i]) col1Changed = colorChanged = true;
 
   #ifdef WLED_ENABLE_LOXONE
   //lox parser
-  pos = req.indexOf(F("LX=")); // Lox primary color
-  if (pos > 0) {
-    int lxValue = getNumVal(&req, pos);
+  if (v[AP_LX]) { // Lox primary color
+    int lxValue = atoi(v[AP_LX]);
     if (parseLx(lxValue, col)) {
       bri = 255;
       nightlightActive = false; //always disable nightlight when toggling
     }
   }
-  pos = req.indexOf(F("LY=")); // Lox secondary color
-  if (pos > 0) {
-    int lxValue = getNumVal(&req, pos);
+  if (v[AP_LY]) { // Lox secondary color
+    int lxValue = atoi(v[AP_LY]);
     if(parseLx(lxValue, colSec)) {
       bri = 255;
       nightlightActive = false; //always disable nightlight when toggling
@@ -747,56 +826,49 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   #endif
 
   //set hue
-  pos = req.indexOf(F("HU="));
-  if (pos > 0) {
-    uint16_t temphue = getNumVal(&req, pos);
+  if (v[AP_HU]) {
+    uint16_t temphue = atoi(v[AP_HU]);
     byte tempsat = 255;
-    pos = req.indexOf(F("SA="));
-    if (pos > 0) {
-      tempsat = getNumVal(&req, pos);
+    if (v[AP_SA]) {
+      tempsat = atoi(v[AP_SA]);
     }
-    byte sec = req.indexOf(F("H2"));
-    colorHStoRGB(temphue, tempsat, (sec>0) ? colSec : col);
-    if (sec>0) col1Changed = true;
-    else       col0Changed = true;
+    bool sec = apiHas(keys, AP_H2);
+    colorHStoRGB(temphue, tempsat, sec ? colSec : col);
+    if (sec) col1Changed = true;
+    else     col0Changed = true;
     colorChanged = true;
   }
 
   //set white spectrum (kelvin)
-  pos = req.indexOf(F("&K="));
-  if (pos > 0) {
-    byte sec = req.indexOf(F("K2"));
-    colorKtoRGB(getNumVal(&req, pos), (sec>0) ? colSec : col);
-    if (sec>0) col1Changed = true;
-    else       col0Changed = true;
+  if (v[AP_K]) {
+    bool sec = apiHas(keys, AP_K2);
+    colorKtoRGB(atoi(v[AP_K]), sec ? colSec : col);
+    if (sec) col1Changed = true;
+    else     col0Changed = true;
     colorChanged = true;
   }
 
   //set color from HEX or 32bit DEC
   byte tmpCol[4];
-  pos = req.indexOf(F("CL="));
-  if (pos > 0) {
-    colorFromDecOrHexString(col, (char*)req.substring(pos + 3).c_str());
+  if (v[AP_CL]) {
+    colorFromDecOrHexString(col, (char*)v[AP_CL]);
     selseg.setColor(0, RGBW32(col[0], col[1], col[2], col[3]), selectedSeg); // defined above (SS= or main)
     col0Changed = colorChanged = true;
   }
-  pos = req.indexOf(F("C2="));
-  if (pos > 0) {
-    colorFromDecOrHexString(colSec, (char*)req.substring(pos + 3).c_str());
+  if (v[AP_C2]) {
+    colorFromDecOrHexString(colSec, (char*)v[AP_C2]);
     selseg.setColor(1, RGBW32(colSec[0], colSec[1], colSec[2], colSec[3]), selectedSeg); // defined above (SS= or main)
     col1Changed = colorChanged = true;
   }
-  pos = req.indexOf(F("C3="));
-  if (pos > 0) {
-    colorFromDecOrHexString(tmpCol, (char*)req.substring(pos + 3).c_str());
+  if (v[AP_C3]) {
+    colorFromDecOrHexString(tmpCol, (char*)v[AP_C3]);
     selseg.setColor(2, RGBW32(tmpCol[0], tmpCol[1], tmpCol[2], tmpCol[3]), selectedSeg); // defined above (SS= or main)
     col2Changed = colorChanged = true;
   }
 
   //set to random hue SR=0->1st SR=1->2nd
-  pos = req.indexOf(F("SR"));
-  if (pos > 0) {
-    byte sec = getNumVal(&req, pos);
+  if (apiHas(keys, AP_SR)) {
+    byte sec = v[AP_SR] ? atoi(v[AP_SR]) : 0;
     _setRandomColor(sec);
     if (sec>0) col1Changed = true;
     else       col0Changed = true;
@@ -804,8 +876,7 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   }
 
   //swap 2nd & 1st
-  pos = req.indexOf(F("SC"));
-  if (pos > 0) {
+  if (apiHas(keys, AP_SC)) {
     byte temp;
     for (uint8_t i=0; i<4; i++) {
       temp      = col[i];
@@ -816,10 +887,10 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   }
 
   //set effect parameters
-  if (updateVal(&req, "FX=", &effectCurrent, 0, strip.getModeCount()-1) && request != nullptr) unloadPlaylist();  //unload playlist if changing FX using web request
-  updateVal(&req, "SX=", &effectSpeed);
-  updateVal(&req, "IX=", &effectIntensity);
-  updateVal(&req, "FP=", &effectPalette, 0, strip.getPaletteCount()-1);
+  if (updateVal(v[AP_FX], &effectCurrent, 0, strip.getModeCount()-1) && (request != nullptr || fromWeb)) unloadPlaylist();  //unload playlist if changing FX using web request
+  updateVal(v[AP_SX], &effectSpeed);
+  updateVal(v[AP_IX], &effectIntensity);
+  updateVal(v[AP_FP], &effectPalette, 0, strip.getPaletteCount()-1);
   strip.setMode(selectedSeg, effectCurrent);
   selseg.speed     = effectSpeed;
   selseg.intensity = effectIntensity;
@@ -827,34 +898,28 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   if (effectCurrent != prevEffect || effectSpeed != prevSpeed || effectIntensity != prevIntensity || effectPalette != prevPalette) effectChanged = true;
 
   //set advanced overlay
-  pos = req.indexOf(F("OL="));
-  if (pos > 0) {
-    overlayCurrent = getNumVal(&req, pos);
+  if (v[AP_OL]) {
+    overlayCurrent = atoi(v[AP_OL]);
   }
 
   //apply macro (deprecated, added for compatibility with pre-0.11 automations)
-  pos = req.indexOf(F("&M="));
-  if (pos > 0) {
-    applyPreset(getNumVal(&req, pos) + 16);
+  if (v[AP_M]) {
+    applyPreset(atoi(v[AP_M]) + 16);
   }
 
   //toggle send UDP direct notifications
-  pos = req.indexOf(F("SN="));
-  if (pos > 0) notifyDirect = (req.charAt(pos+3) != '0');
+  if (v[AP_SN]) notifyDirect = (v[AP_SN][0] != '0');
 
   //toggle receive UDP direct notifications
-  pos = req.indexOf(F("RN="));
-  if (pos > 0) receiveNotifications = (req.charAt(pos+3) != '0');
+  if (v[AP_RN]) receiveNotifications = (v[AP_RN][0] != '0');
 
   //receive live data via UDP/Hyperion
-  pos = req.indexOf(F("RD="));
-  if (pos > 0) receiveDirect = (req.charAt(pos+3) != '0');
+  if (v[AP_RD]) receiveDirect = (v[AP_RD][0] != '0');
 
   //main toggle on/off (parse before nightlight, #1214)
-  pos = req.indexOf(F("&T="));
-  if (pos > 0) {
+  if (v[AP_T]) {
     nightlightActive = false; //always disable nightlight when toggling
-    switch (getNumVal(&req, pos))
+    switch (atoi(v[AP_T]))
     {
       case 0: if (bri != 0){briLast = bri; bri = 0;} break; //off, only if it was previously on
       case 1: if (bri == 0) bri = briLast; break; //on, only if it was previously off
@@ -863,17 +928,15 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   }
 
   //toggle nightlight mode
-  bool aNlDef = false;
-  if (req.indexOf(F("&ND")) > 0) aNlDef = true;
-  pos = req.indexOf(F("NL="));
-  if (pos > 0)
+  bool aNlDef = apiHas(keys, AP_ND);
+  if (v[AP_NL])
   {
-    if (req.charAt(pos+3) == '0')
+    if (v[AP_NL][0] == '0')
     {
       nightlightActive = false;
     } else {
       nightlightActive = true;
-      if (!aNlDef) nightlightDelayMins = getNumVal(&req, pos);
+      if (!aNlDef) nightlightDelayMins = atoi(v[AP_NL]);
       nightlightStartTime = millis();
     }
   } else if (aNlDef)
@@ -883,74 +946,62 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   }
 
   //set nightlight target brightness
-  pos = req.indexOf(F("NT="));
-  if (pos > 0) {
-    nightlightTargetBri = getNumVal(&req, pos);
+  if (v[AP_NT]) {
+    nightlightTargetBri = atoi(v[AP_NT]);
     nightlightActiveOld = false; //re-init
   }
 
   //toggle nightlight fade
-  pos = req.indexOf(F("NF="));
-  if (pos > 0)
+  if (v[AP_NF])
   {
-    nightlightMode = getNumVal(&req, pos);
+    nightlightMode = atoi(v[AP_NF]);
 
     nightlightActiveOld = false; //re-init
   }
   if (nightlightMode > NL_MODE_SUN) nightlightMode = NL_MODE_SUN;
 
-  pos = req.indexOf(F("TT="));
-  if (pos > 0) transitionDelay = getNumVal(&req, pos);
+  if (v[AP_TT]) transitionDelay = atoi(v[AP_TT]);
 
   //set time (unix timestamp)
-  pos = req.indexOf(F("ST="));
-  if (pos > 0) {
-    setTimeFromAPI(getNumVal(&req, pos));
+  if (v[AP_ST]) {
+    setTimeFromAPI(atol(v[AP_ST]));
   }
 
   //set countdown goal (unix timestamp)
-  pos = req.indexOf(F("CT="));
-  if (pos > 0) {
-    countdownTime = getNumVal(&req, pos);
+  if (v[AP_CT]) {
+    countdownTime = atol(v[AP_CT]);
     if (countdownTime - toki.second() > 0) countdownOverTriggered = false;
   }
 
-  pos = req.indexOf(F("LO="));
-  if (pos > 0) {
-    realtimeOverride = getNumVal(&req, pos);
+  if (v[AP_LO]) {
+    realtimeOverride = atoi(v[AP_LO]);
     if (realtimeOverride > 2) realtimeOverride = REALTIME_OVERRIDE_ALWAYS;
   }
 
-  pos = req.indexOf(F("RB"));
-  if (pos > 0) doReboot = true;
+  if (apiHas(keys, AP_RB)) doReboot = true;
 
   //cronixie
   #ifndef WLED_DISABLE_CRONIXIE
   //mode, 1 countdown
-  pos = req.indexOf(F("NM="));
-  if (pos > 0) countdownMode = (req.charAt(pos+3) != '0');
-  
-  pos = req.indexOf(F("NX=")); //sets digits to code
-  if (pos > 0) {
-    strlcpy(cronixieDisplay, req.substring(pos + 3, pos + 9).c_str(), 7);
+  if (v[AP_NM]) countdownMode = (v[AP_NM][0] != '0');
+
+  if (v[AP_NX]) { //sets digits to code
+    strlcpy(cronixieDisplay, v[AP_NX], 7);
     setCronixie();
   }
 
-  pos = req.indexOf(F("NB="));
-  if (pos > 0) //sets backlight
+  if (v[AP_NB]) //sets backlight
   {
-    cronixieBacklight = (req.charAt(pos+3) != '0');
+    cronixieBacklight = (v[AP_NB][0] != '0');
   }
   #endif
 
-  pos = req.indexOf(F("U0=")); //user var 0
-  if (pos > 0) {
-    userVar0 = getNumVal(&req, pos);
+  if (v[AP_U0]) { //user var 0
+    userVar0 = atoi(v[AP_U0]);
   }
 
-  pos = req.indexOf(F("U1=")); //user var 1
-  if (pos > 0) {
-    userVar1 = getNumVal(&req, pos);
+  if (v[AP_U1]) { //user var 1
+    userVar1 = atoi(v[AP_U1]);
   }
   //you can add more if you need
 
@@ -972,14 +1023,22 @@ bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply)
   setValuesFromMainSeg();
   //end of temporary fix code
 
-  if (!apply) return true; //when called by JSON API, do not call colorUpdated() here
+  if (!apply) { //when called by JSON API, do not call colorUpdated() here
+    if (commitTx) strip.commitTransaction();
+    return true;
+  }
   
   //internal call, does not send XML response
-  pos = req.indexOf(F("IN"));
-  if (pos < 1) XML_response(request);
+  if (!apiHas(keys, AP_IN)) XML_response(request);
 
-  pos = req.indexOf(F("&NN")); //do not send UDP notifications this time
-  colorUpdated((pos > 0) ? CALL_MODE_NO_NOTIFY : CALL_MODE_DIRECT_CHANGE);
+  //&NN: do not send UDP notifications this time
+  colorUpdated(apiHas(keys, AP_NN) ? CALL_MODE_NO_NOTIFY : CALL_MODE_DIRECT_CHANGE);
+  if (commitTx) strip.commitTransaction();
 
   return true;
 }
+
+bool handleSet(AsyncWebServerRequest *request, const String& req, bool apply, bool fromWeb)
+{
+  return handleSet(request, req.c_str(), apply, fromWeb);
+}
@@ -53,11 +53,14 @@ typedef struct ip_addr ip4_addr_t;
 #define DDP_PUSH_FLAG 0x01
 #define DDP_TIMECODE_FLAG 0x10
 
-#define ARTNET_OPCODE_OPDMX 0x5000
+#define ARTNET_OPCODE_OPDMX  0x5000
+#define ARTNET_OPCODE_OPSYNC 0x5200
 
-#define P_E131   0
-#define P_ARTNET 1
-#define P_DDP    2
+#define P_E131        0
+#define P_ARTNET      1
+#define P_DDP         2
+#define P_E131_SYNC   3
+#define P_ARTNET_SYNC 4
 
 // E1.31 Packet Offsets
 #define E131_ROOT_PREAMBLE_SIZE 0
@@ -84,6 +87,10 @@ typedef struct ip_addr ip4_addr_t;
 #define E131_DMP_COUNT 123
 #define E131_DMP_DATA 125
 
+// E1.31 Synchronization Packet Offsets
+#define E131_SYNC_SEQ 44
+#define E131_SYNC_ADDR 45
+
 // E1.31 Packet Structure
 typedef union {
     struct { //E1.31 packet
@@ -160,7 +167,9 @@ class ESPAsyncE131 {
     static const uint8_t ACN_ID[];
 	  static const uint8_t ART_ID[];
     static const uint32_t VECTOR_ROOT = 4;
+    static const uint32_t VECTOR_ROOT_EXTENDED = 8;
     static const uint32_t VECTOR_FRAME = 2;
+    static const uint32_t VECTOR_FRAME_SYNC = 1;
     static const uint8_t VECTOR_DMP = 2;
 
     AsyncUDP        udp;        // AsyncUDP
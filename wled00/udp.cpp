@@ -169,33 +169,147 @@ void sendTPM2Ack() {
 }
 
 
-void handleNotifications()
+/*
+ * Realtime input statistics
+ * Counted per realtime mode and per source address, rates are updated once per second from the main loop.
+ */
+#define RT_STATS_SOURCES 4          //sources tracked, the least recently seen is replaced
+#define RT_STATS_LATENCY_BUCKETS 8
+#define RT_STATS_MQTT_INTERVAL 10000
+
+static uint32_t rtCounters[REALTIME_MODE_WS +1][RT_STAT_COUNT];
+static uint16_t rtPps[REALTIME_MODE_WS +1], rtFps[REALTIME_MODE_WS +1];
+static uint32_t rtLastPackets[REALTIME_MODE_WS +1], rtLastFrames[REALTIME_MODE_WS +1];
+static struct {
+  IPAddress ip;
+  byte mode;
+  uint16_t pps;
+  uint32_t packets, lastPackets, lastSeen;
+} rtSources[RT_STATS_SOURCES];
+static const uint8_t rtLatencyBounds[RT_STATS_LATENCY_BUCKETS -1] PROGMEM = {1, 2, 5, 10, 20, 50, 100}; //ms
+static uint32_t rtLatency[RT_STATS_LATENCY_BUCKETS]; //receive-to-show latency histogram
+static uint32_t rtRxMicros = 0;     //micros() of the first packet not shown yet
+static uint32_t rtStatsTime = 0, rtStatsMqttTime = 0;
+
+const __FlashStringHelper* realtimeModeName(byte md)
 {
-  IPAddress localIP;
+  switch (md) {
+    case REALTIME_MODE_UDP:      return F("UDP");
+    case REALTIME_MODE_HYPERION: return F("Hyperion");
+    case REALTIME_MODE_E131:     return F("E1.31");
+    case REALTIME_MODE_ADALIGHT: return F("USB Adalight/TPM2");
+    case REALTIME_MODE_ARTNET:   return F("Art-Net");
+    case REALTIME_MODE_TPM2NET:  return F("tpm2.net");
+    case REALTIME_MODE_DDP:      return F("DDP");
+    case REALTIME_MODE_WS:       return F("WebSocket");
+  }
+  return F("");
+}
 
-  //send second notification if enabled
-  if(udpConnected && notificationTwoRequired && millis()-notificationSentTime > 250){
-    notify(notificationSentCallMode,true);
+void realtimeStatsAdd(byte md, uint8_t stat, uint16_t n)
+{
+  if (md > REALTIME_MODE_WS || stat >= RT_STAT_COUNT) return;
+  rtCounters[md][stat] += n;
+}
+
+//called for every realtime packet received
+void realtimeStatsPacket(byte md, IPAddress ip)
+{
+  realtimeStatsAdd(md, RT_STAT_PACKETS);
+  if (!rtRxMicros) rtRxMicros = micros() | 1;
+  if (ip[0] == 0) return; //serial
+
+  uint8_t s = RT_STATS_SOURCES, oldest = 0;
+  for (uint8_t i = 0; i < RT_STATS_SOURCES; i++) {
+    if (rtSources[i].packets && rtSources[i].ip == ip && rtSources[i].mode == md) { s = i; break; }
+    if (rtSources[i].lastSeen < rtSources[oldest].lastSeen) oldest = i;
   }
-  
-  if (e131NewData && millis() - strip.getLastShow() > 15)
-  {
-    e131NewData = false;
-    strip.show();
+  if (s == RT_STATS_SOURCES) { //new source, replaces the least recently seen
+    s = oldest;
+    rtSources[s].ip = ip;
+    rtSources[s].mode = md;
+    rtSources[s].packets = rtSources[s].lastPackets = 0;
+    rtSources[s].pps = 0;
   }
+  rtSources[s].packets++;
+  rtSources[s].lastSeen = millis();
+}
 
-  //unlock strip when realtime UDP times out
-  if (realtimeMode && millis() > realtimeTimeout)
-  {
-    if (realtimeOverride == REALTIME_OVERRIDE_ONCE) realtimeOverride = REALTIME_OVERRIDE_NONE;
-    strip.setBrightness(scaledBri(bri));
-    realtimeMode = REALTIME_MODE_INACTIVE;
-    realtimeIP[0] = 0;
+//called when realtime data is shown
+void realtimeStatsShow()
+{
+  realtimeStatsAdd(realtimeMode, RT_STAT_FRAMES);
+  if (!rtRxMicros) return;
+  uint32_t ms = (micros() - rtRxMicros) / 1000;
+  rtRxMicros = 0;
+  uint8_t b = 0;
+  while (b < RT_STATS_LATENCY_BUCKETS -1 && ms >= pgm_read_byte(&rtLatencyBounds[b])) b++;
+  rtLatency[b]++;
+}
+
+//called from the main loop, updates packet and frame rates
+void handleRealtimeStats()
+{
+  if (millis() - rtStatsTime < 1000) return;
+  rtStatsTime = millis();
+  for (uint8_t md = 0; md <= REALTIME_MODE_WS; md++) {
+    rtPps[md] = rtCounters[md][RT_STAT_PACKETS] - rtLastPackets[md];
+    rtFps[md] = rtCounters[md][RT_STAT_FRAMES]  - rtLastFrames[md];
+    rtLastPackets[md] = rtCounters[md][RT_STAT_PACKETS];
+    rtLastFrames[md]  = rtCounters[md][RT_STAT_FRAMES];
   }
+  for (uint8_t i = 0; i < RT_STATS_SOURCES; i++) {
+    rtSources[i].pps = rtSources[i].packets - rtSources[i].lastPackets;
+    rtSources[i].lastPackets = rtSources[i].packets;
+  }
+  if (realtimeMode && millis() - rtStatsMqttTime > RT_STATS_MQTT_INTERVAL) {
+    rtStatsMqttTime = millis();
+    publishMqttRealtimeStats();
+  }
+}
 
-  //receive UDP notifications
-  if (!udpConnected) return;
-    
+void serializeRealtimeStats(JsonObject root)
+{
+  JsonObject proto = root.createNestedObject(F("proto"));
+  for (uint8_t md = REALTIME_MODE_UDP; md <= REALTIME_MODE_WS; md++) {
+    if (!rtCounters[md][RT_STAT_PACKETS]) continue;
+    JsonObject p = proto.createNestedObject(realtimeModeName(md));
+    p[F("pps")]    = rtPps[md];
+    p[F("fps")]    = rtFps[md];
+    p[F("pkts")]   = rtCounters[md][RT_STAT_PACKETS];
+    p[F("frames")] = rtCounters[md][RT_STAT_FRAMES];
+    p[F("gaps")]   = rtCounters[md][RT_STAT_GAPS];
+    p[F("skip")]   = rtCounters[md][RT_STAT_SKIPPED];
+    p[F("torn")]   = rtCounters[md][RT_STAT_TORN];
+    p[F("dup")]    = rtCounters[md][RT_STAT_DUP];
+  }
+
+  JsonArray src = root.createNestedArray(F("src"));
+  for (uint8_t i = 0; i < RT_STATS_SOURCES; i++) {
+    if (!rtSources[i].packets) continue;
+    JsonObject s = src.createNestedObject();
+    s[F("ip")]   = rtSources[i].ip.toString();
+    s["lm"]      = realtimeModeName(rtSources[i].mode);
+    s[F("pps")]  = rtSources[i].pps;
+    s[F("pkts")] = rtSources[i].packets;
+    s[F("age")]  = (millis() - rtSources[i].lastSeen) / 1000;
+  }
+
+  //latency histogram, bucket i holds latencies below lat_ms[i] (the last one all others)
+  JsonArray latMs = root.createNestedArray(F("lat_ms"));
+  for (uint8_t b = 0; b < RT_STATS_LATENCY_BUCKETS -1; b++) latMs.add(pgm_read_byte(&rtLatencyBounds[b]));
+  JsonArray lat = root.createNestedArray(F("lat"));
+  for (uint8_t b = 0; b < RT_STATS_LATENCY_BUCKETS; b++) lat.add(rtLatency[b]);
+}
+
+
+static bool udpShowPending = false; //realtime packets were received but not shown yet
+static byte udpIn[UDP_IN_MAXSIZE +1]; //receive buffer, packets are parsed in place (+1 for the JSON/HTTP API terminator)
+
+//reads and handles one packet from the notifier, notifier2 or raw RGB socket, false if none was pending
+static bool handleUdpPacket()
+{
+  IPAddress localIP;
   bool isSupp = false;
   uint16_t packetSize = notifierUdp.parsePacket();
   if (!packetSize && udp2Connected) {
@@ -207,41 +321,35 @@ void handleNotifications()
   if (!packetSize && udpRgbConnected) {
     packetSize = rgbUdp.parsePacket();
     if (packetSize) {
-      if (!receiveDirect) return;
-      if (packetSize > UDP_IN_MAXSIZE || packetSize < 3) return;
+      if (!receiveDirect) return true;
+      if (packetSize > UDP_IN_MAXSIZE || packetSize < 3) return true;
       realtimeIP = rgbUdp.remoteIP();
       DEBUG_PRINTLN(rgbUdp.remoteIP());
-      uint8_t lbuf[packetSize];
-      rgbUdp.read(lbuf, packetSize);
+      realtimeStatsPacket(REALTIME_MODE_HYPERION, realtimeIP);
+      rgbUdp.read(udpIn, packetSize);
       realtimeLock(realtimeTimeoutMs, REALTIME_MODE_HYPERION);
-      if (realtimeOverride) return;
-      uint16_t id = 0;
-      uint16_t totalLen = strip.getLengthTotal();
-      for (uint16_t i = 0; i < packetSize -2; i += 3)
-      {
-        setRealtimePixel(id, lbuf[i], lbuf[i+1], lbuf[i+2], 0);
-        id++; if (id >= totalLen) break;
-      }
-      strip.show();
-      return;
+      if (realtimeOverride) return true;
+      setRealtimePixels(0, udpIn, packetSize/3, RT_PIXEL_RGB | realtimeGamma());
+      udpShowPending = true;
+      return true;
     } 
   }
 
-  if (!(receiveNotifications || receiveDirect)) return;
+  if (!packetSize) return false;
+  if (!(receiveNotifications || receiveDirect)) return true;
   
   localIP = Network.localIP();
   //notifier and UDP realtime
-  if (!packetSize || packetSize > UDP_IN_MAXSIZE) return;
-  if (!isSupp && notifierUdp.remoteIP() == localIP) return; //don't process broadcasts we send ourselves
+  if (packetSize > UDP_IN_MAXSIZE) return true;
+  if (!isSupp && notifierUdp.remoteIP() == localIP) return true; //don't process broadcasts we send ourselves
 
-  uint8_t udpIn[packetSize +1];
   uint16_t len;
   if (isSupp) len = notifier2Udp.read(udpIn, packetSize);
   else        len =  notifierUdp.read(udpIn, packetSize);
 
   // WLED nodes info notifications
   if (isSupp && udpIn[0] == 255 && udpIn[1] == 1 && len >= 40) {
-    if (!nodeListEnabled || notifier2Udp.remoteIP() == localIP) return;
+    if (!nodeListEnabled || notifier2Udp.remoteIP() == localIP) return true;
 
     uint8_t unit = udpIn[39];
     NodesMap::iterator it = Nodes.find(unit);
@@ -267,15 +375,15 @@ void handleNotifications()
           build |= udpIn[40+i]<<(8*i);
       it->second.build = build;
     }
-    return;
+    return true;
   }
 
   //wled notifier, ignore if realtime packets active
   if (udpIn[0] == 0 && !realtimeMode && receiveNotifications)
   {
     //ignore notification if received within a second after sending a notification ourselves
-    if (millis() - notificationSentTime < 1000) return;
-    if (udpIn[1] > 199) return; //do not receive custom versions
+    if (millis() - notificationSentTime < 1000) return true;
+    if (udpIn[1] > 199) return true; //do not receive custom versions
 
     //compatibilityVersionByte: 
     byte version = udpIn[11];
@@ -283,8 +391,8 @@ void handleNotifications()
     // if we are not part of any sync group ignore message
     if (version < 9 || version > 199) {
       // legacy senders are treated as if sending in sync group 1 only
-      if (!(receiveGroups & 0x01)) return;
-    } else if (!(receiveGroups & udpIn[36])) return;
+      if (!(receiveGroups & 0x01)) return true;
+    } else if (!(receiveGroups & udpIn[36])) return true;
     
     bool someSel = (receiveNotificationBrightness || receiveNotificationColor || receiveNotificationEffects);
 
@@ -401,10 +509,10 @@ void handleNotifications()
     
     if (receiveNotificationBrightness || !someSel) bri = udpIn[2];
     colorUpdated(CALL_MODE_NOTIFICATION);
-    return;
+    return true;
   }
 
-  if (!receiveDirect) return;
+  if (!receiveDirect) return true;
   
   //TPM2.NET
   if (udpIn[0] == 0x9c)
@@ -413,36 +521,31 @@ void handleNotifications()
     //if the number of LEDs in your installation doesn't allow that, please include padding bytes at the end of the last packet
     byte tpmType = udpIn[1];
     if (tpmType == 0xaa) { //TPM2.NET polling, expect answer
-      sendTPM2Ack(); return;
+      sendTPM2Ack(); return true;
     }
-    if (tpmType != 0xda) return; //return if notTPM2.NET data
+    if (tpmType != 0xda) return true; //return if notTPM2.NET data
 
     realtimeIP = (isSupp) ? notifier2Udp.remoteIP() : notifierUdp.remoteIP();
+    realtimeStatsPacket(REALTIME_MODE_TPM2NET, realtimeIP);
     realtimeLock(realtimeTimeoutMs, REALTIME_MODE_TPM2NET);
-    if (realtimeOverride) return;
+    if (realtimeOverride) return true;
 
     tpmPacketCount++; //increment the packet count
     if (tpmPacketCount == 1) tpmPayloadFrameSize = (udpIn[2] << 8) + udpIn[3]; //save frame size for the whole payload if this is the first packet
     byte packetNum = udpIn[4]; //starts with 1!
     byte numPackets = udpIn[5];
+    if (packetNum > tpmPacketCount) realtimeStatsAdd(REALTIME_MODE_TPM2NET, RT_STAT_GAPS, packetNum - tpmPacketCount);
 
     uint16_t id = (tpmPayloadFrameSize/3)*(packetNum-1); //start LED
-    uint16_t totalLen = strip.getLengthTotal();
-    for (uint16_t i = 6; i < tpmPayloadFrameSize + 4; i += 3)
-    {
-      if (id < totalLen)
-      {
-        setRealtimePixel(id, udpIn[i], udpIn[i+1], udpIn[i+2], 0);
-        id++;
-      }
-      else break;
-    }
+    uint16_t count = tpmPayloadFrameSize/3;
+    if (packetSize < 6 + count*3) count = (packetSize > 6) ? (packetSize - 6)/3 : 0;
+    setRealtimePixels(id, udpIn + 6, count, RT_PIXEL_RGB | realtimeGamma());
     if (tpmPacketCount == numPackets) //reset packet count and show if all packets were received
     {
       tpmPacketCount = 0;
-      strip.show();
+      udpShowPending = true;
     }
-    return;
+    return true;
   }
 
   //UDP realtime: 1 warls 2 drgb 3 drgbw
@@ -450,63 +553,9 @@ void handleNotifications()
   {
     realtimeIP = (isSupp) ? notifier2Udp.remoteIP() : notifierUdp.remoteIP();
     DEBUG_PRINTLN(realtimeIP);
-    if (packetSize < 2) return;
-
-    if (udpIn[1] == 0)
-    {
-      realtimeTimeout = 0;
-      return;
-    } else {
-      realtimeLock(udpIn[1]*1000 +1, REALTIME_MODE_UDP);
-    }
-    if (realtimeOverride) return;
-
-    uint16_t totalLen = strip.getLengthTotal();
-    if (udpIn[0] == 1) //warls
-    {
-      for (uint16_t i = 2; i < packetSize -3; i += 4)
-      {
-        setRealtimePixel(udpIn[i], udpIn[i+1], udpIn[i+2], udpIn[i+3], 0);
-      }
-    } else if (udpIn[0] == 2) //drgb
-    {
-      uint16_t id = 0;
-      for (uint16_t i = 2; i < packetSize -2; i += 3)
-      {
-        setRealtimePixel(id, udpIn[i], udpIn[i+1], udpIn[i+2], 0);
-
-        id++; if (id >= totalLen) break;
-      }
-    } else if (udpIn[0] == 3) //drgbw
-    {
-      uint16_t id = 0;
-      for (uint16_t i = 2; i < packetSize -3; i += 4)
-      {
-        setRealtimePixel(id, udpIn[i], udpIn[i+1], udpIn[i+2], udpIn[i+3]);
-        
-        id++; if (id >= totalLen) break;
-      }
-    } else if (udpIn[0] == 4) //dnrgb
-    {
-      uint16_t id = ((udpIn[3] << 0) & 0xFF) + ((udpIn[2] << 8) & 0xFF00);
-      for (uint16_t i = 4; i < packetSize -2; i += 3)
-      {
-        if (id >= totalLen) break;
-        setRealtimePixel(id, udpIn[i], udpIn[i+1], udpIn[i+2], 0);
-        id++;
-      }
-    } else if (udpIn[0] == 5) //dnrgbw
-    {
-      uint16_t id = ((udpIn[3] << 0) & 0xFF) + ((udpIn[2] << 8) & 0xFF00);
-      for (uint16_t i = 4; i < packetSize -2; i += 4)
-      {
-        if (id >= totalLen) break;
-        setRealtimePixel(id, udpIn[i], udpIn[i+1], udpIn[i+2], udpIn[i+3]);
-        id++;
-      }
-    }
-    strip.show();
-    return;
+    realtimeStatsPacket(REALTIME_MODE_UDP, realtimeIP);
+    if (handleRealtimeDirect(udpIn, packetSize, REALTIME_MODE_UDP)) udpShowPending = true;
+    return true;
   }
 
   // API over UDP
@@ -516,27 +565,135 @@ void handleNotifications()
     String apireq = "win&";
     apireq += (char*)udpIn;
     handleSet(nullptr, apireq);
-  } else if (udpIn[0] == '{') { //JSON API
-    DynamicJsonDocument jsonBuffer(2048);
-    DeserializationError error = deserializeJson(jsonBuffer, udpIn);
-    JsonObject root = jsonBuffer.as<JsonObject>();
+  } else if (udpIn[0] == '{' || IS_MSGPACK_MAP(udpIn[0])) { //JSON or MessagePack API
+    #ifdef WLED_USE_DYNAMIC_JSON
+    DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+    #else
+    if (!requestJSONBufferLock(18)) return true;
+    #endif
+    DeserializationError error = deserializeCommand(doc, (char*)udpIn, packetSize, udpIn[0] != '{'); //in place, strings point into udpIn
+    JsonObject root = doc.as<JsonObject>();
     if (!error && !root.isNull()) deserializeState(root);
+    releaseJSONBufferLock();
   }
+  return true;
 }
 
 
-void setRealtimePixel(uint16_t i, byte r, byte g, byte b, byte w)
+//UDP realtime protocols (1 WARLS, 2 DRGB, 3 DRGBW, 4 DNRGB, 5 DNRGBW), also accepted as binary WebSocket messages
+//byte 1 is the timeout in seconds (0 ends realtime mode), returns true if pixels were set and need to be shown
+bool handleRealtimeDirect(const byte* data, uint16_t len, byte md)
 {
-  uint16_t pix = i + arlsOffset;
-  if (pix < strip.getLengthTotal())
+  if (len < 2) return false;
+
+  if (data[1] == 0)
   {
-    if (!arlsDisableGammaCorrection && strip.gammaCorrectCol)
+    realtimeTimeout = 0;
+    return false;
+  } else {
+    realtimeLock(data[1]*1000 +1, md);
+  }
+  if (realtimeOverride) return false;
+
+  uint8_t gamma = realtimeGamma();
+  if (data[0] == 1) //warls
+  {
+    for (uint16_t i = 2; i +3 < len; i += 4)
     {
-      strip.setPixelColor(pix, strip.gamma8(r), strip.gamma8(g), strip.gamma8(b), strip.gamma8(w));
-    } else {
-      strip.setPixelColor(pix, r, g, b, w);
+      setRealtimePixels(data[i], &data[i+1], 1, RT_PIXEL_RGB | gamma);
     }
+  } else if (data[0] == 2) //drgb
+  {
+    setRealtimePixels(0, data + 2, (len -2)/3, RT_PIXEL_RGB | gamma);
+  } else if (data[0] == 3) //drgbw
+  {
+    setRealtimePixels(0, data + 2, (len -2)/4, RT_PIXEL_RGBW | gamma);
+  } else if (data[0] == 4) //dnrgb
+  {
+    if (len < 4) return false;
+    uint16_t id = ((data[3] << 0) & 0xFF) + ((data[2] << 8) & 0xFF00);
+    if (len > 4) setRealtimePixels(id, data + 4, (len -4)/3, RT_PIXEL_RGB | gamma);
+  } else if (data[0] == 5) //dnrgbw
+  {
+    if (len < 4) return false;
+    uint16_t id = ((data[3] << 0) & 0xFF) + ((data[2] << 8) & 0xFF00);
+    if (len > 4) setRealtimePixels(id, data + 4, (len -4)/4, RT_PIXEL_RGBW | gamma);
+  }
+  return true;
+}
+
+void handleNotifications()
+{
+  //send second notification if enabled
+  if(udpConnected && notificationTwoRequired && millis()-notificationSentTime > 250){
+    notify(notificationSentCallMode,true);
+  }
+  
+  handleE131FrameTimeout();
+  handleDDPPlayout();
+  handleRealtimeStats();
+  if (e131NewData && millis() - strip.getLastShow() > 15)
+  {
+    e131NewData = false;
+    strip.show();
+    realtimeStatsShow();
+  }
+
+  //unlock strip when realtime UDP times out
+  if (realtimeMode && millis() > realtimeTimeout)
+  {
+    if (realtimeOverride == REALTIME_OVERRIDE_ONCE) realtimeOverride = REALTIME_OVERRIDE_NONE;
+    strip.setBrightness(scaledBri(bri));
+    realtimeMode = REALTIME_MODE_INACTIVE;
+    realtimeIP[0] = 0;
+  }
+
+  //receive UDP notifications, drain all pending packets within the time budget
+  if (!udpConnected) return;
+  uint32_t start = micros();
+  while (handleUdpPacket() && micros() - start < UDP_RECEIVE_BUDGET_US);
+
+  //realtime packets of one burst are shown together
+  if (udpShowPending) {
+    udpShowPending = false;
+    strip.show();
+    realtimeStatsShow();
+  }
+}
+
+
+//RT_PIXEL_GAMMA if realtime data should be gamma corrected
+uint8_t realtimeGamma()
+{
+  return (!arlsDisableGammaCorrection && strip.gammaCorrectCol) ? RT_PIXEL_GAMMA : 0;
+}
+
+//realtime pixels that can receive data, including those moved off the strip by a negative arlsOffset
+uint16_t realtimeFrameLeds()
+{
+  uint16_t totalLen = strip.getLengthTotal();
+  return (arlsOffset < 0 && totalLen - arlsOffset <= UINT16_MAX) ? totalLen - arlsOffset : totalLen;
+}
+
+//bulk realtime pixel ingest, sets count pixels from realtime pixel i on (arlsOffset is applied)
+//data holds 3 (RT_PIXEL_RGB) or 4 (RT_PIXEL_RGBW) channels per pixel
+void setRealtimePixels(uint16_t i, const byte* data, uint16_t count, uint8_t format)
+{
+  int32_t pix = (int32_t)i + arlsOffset;
+  if (pix < 0) { //pixels before the start of the strip
+    if (-pix >= count) return;
+    data  += (-pix) * ((format & RT_PIXEL_RGBW) ? 4 : 3);
+    count += pix;
+    pix = 0;
   }
+  if (pix > UINT16_MAX) return;
+  strip.setRealtimePixels(pix, data, count, format);
+}
+
+void setRealtimePixel(uint16_t i, byte r, byte g, byte b, byte w)
+{
+  byte rgbw[4] = {r, g, b, w};
+  setRealtimePixels(i, rgbw, 1, RT_PIXEL_RGBW | realtimeGamma());
 }
 
 /*********************************************************************************************\
@@ -632,97 +789,305 @@ void sendSysInfoUDP()
 // 1440 channels per packet
 #define DDP_CHANNELS_PER_PACKET 1440 // 480 leds
 
+#define E131_HEADER_LEN 126          // root, framing and DMP layer up to and including the DMX start code
+#define E131_SYNCPACKET_LEN 49
+#define ARTNET_HEADER_LEN 18
+#define ARTNET_SYNCPACKET_LEN 14
+#define DMX_CHANNELS_PER_UNIVERSE 512
+
+// largest packet we ever send, reused for every frame
+#define OUT_PACKET_LEN (DDP_HEADER_LEN + DDP_CHANNELS_PER_PACKET)
+
+static const byte E131_ACN_ID[]  PROGMEM = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 }; // "ASC-E1.17"
+static const byte ARTNET_ID[]    PROGMEM = { 0x41, 0x72, 0x74, 0x2d, 0x4e, 0x65, 0x74, 0x00 };                         // "Art-Net"
+
+WiFiUDP ddpUdp;             // shared by all network busses, keeps its socket and TX buffer between frames
+byte* outPacket = nullptr;  // packet buffer, allocated on first use and kept
+byte e131Cid[16] = {0};     // E1.31 component identifier, derived from MAC address
+
+// frame sync and timing of network output, see realtimeBroadcastSync()
+#define NET_SYNC_DDP    0x01
+#define NET_SYNC_E131   0x02
+#define NET_SYNC_ARTNET 0x04
+uint8_t netSyncPending = 0;                        // protocols that sent data without latching it yet
+uint8_t e131SyncCount = 0;                         // E1.31 targets waiting for a sync packet
+IPAddress e131SyncIP[WLED_MAX_BUSSES];
+uint16_t e131SyncUniverse[WLED_MAX_BUSSES];
+uint8_t e131SyncSequence = 0;
+uint32_t netFrameStart = 0, netDataSent = 0;       // micros() of first and last data packet of the current frame
+uint32_t netFirstLatch = 0, netLastLatch = 0;      // micros() of first and last packet that made a node display the frame
+bool netLatched = false;
+
+static bool sendOutPacket(IPAddress client, uint16_t port, uint16_t len) {
+  if (!ddpUdp.beginPacket(client, port)) {
+    DEBUG_PRINTLN(F("WiFiUDP.beginPacket returned an error"));
+    return false;
+  }
+  ddpUdp.write(outPacket, len);
+  if (!ddpUdp.endPacket()) {
+    DEBUG_PRINTLN(F("WiFiUDP.endPacket returned an error"));
+    return false;
+  }
+  return true;
+}
+
+// records the time a node was told to display the frame
+static void markLatch() {
+  uint32_t now = micros();
+  if (!netLatched) netFirstLatch = now;
+  netLastLatch = now;
+  netLatched = true;
+}
+
+static void writeE131Cid(byte* p) {
+  if (!e131Cid[0]) { //version 4 style UUID from MAC
+    WiFi.macAddress(e131Cid + 10);
+    e131Cid[0] = 0x57; e131Cid[1] = 0x4c; e131Cid[2] = 0x45; e131Cid[3] = 0x44; //"WLED"
+    e131Cid[6] = 0x40; e131Cid[8] = 0x80;
+  }
+  memcpy(p, e131Cid, 16);
+}
+
+// writes E1.31 data packet header for a universe with dataLen DMX channels
+// syncUniverse - if not 0, receivers hold the data until a sync packet for that universe arrives
+static void writeE131Header(byte* p, uint16_t universe, uint8_t seq, uint16_t dataLen, uint16_t syncUniverse) {
+  memset(p, 0, E131_HEADER_LEN);
+  // root layer
+  p[1] = 0x10;                                             //preamble size
+  memcpy_P(p + 4, E131_ACN_ID, sizeof(E131_ACN_ID));
+  uint16_t flen = 0x7000 | (E131_HEADER_LEN - 16 + dataLen);
+  p[16] = flen >> 8; p[17] = flen & 0xFF;
+  p[21] = 0x04;                                            //VECTOR_ROOT_E131_DATA
+  writeE131Cid(p + 22);
+  // framing layer
+  flen = 0x7000 | (E131_HEADER_LEN - 38 + dataLen);
+  p[38] = flen >> 8; p[39] = flen & 0xFF;
+  p[43] = 0x02;                                            //VECTOR_E131_DATA_PACKET
+  strncpy((char*)p + 44, serverDescription, 63);           //source name
+  p[108] = 100;                                            //priority
+  p[109] = syncUniverse >> 8; p[110] = syncUniverse & 0xFF;
+  p[111] = seq;
+  p[113] = universe >> 8; p[114] = universe & 0xFF;
+  // DMP layer
+  flen = 0x7000 | (E131_HEADER_LEN - 115 + dataLen);
+  p[115] = flen >> 8; p[116] = flen & 0xFF;
+  p[117] = 0x02;                                           //VECTOR_DMP_SET_PROPERTY
+  p[118] = 0xa1;                                           //address & data type
+  p[122] = 0x01;                                           //address increment
+  p[123] = (dataLen +1) >> 8; p[124] = (dataLen +1) & 0xFF; //property value count incl. start code
+}
+
+// writes Art-Net OpDmx packet header for a 15 bit port address, dataLen must be even
+static void writeArtNetHeader(byte* p, uint16_t universe, uint8_t seq, uint16_t dataLen) {
+  memcpy_P(p, ARTNET_ID, sizeof(ARTNET_ID));
+  p[8]  = ARTNET_OPCODE_OPDMX & 0xFF;                      //OpCode, little endian
+  p[9]  = ARTNET_OPCODE_OPDMX >> 8;
+  p[10] = 0; p[11] = 14;                                   //protocol version
+  p[12] = seq;
+  p[13] = 0;                                               //physical
+  p[14] = universe & 0xFF;                                 //SubUni
+  p[15] = (universe >> 8) & 0x7F;                          //Net
+  p[16] = dataLen >> 8; p[17] = dataLen & 0xFF;
+}
+
+uint8_t sequenceNumber = 0; // this needs to be shared across all outputs
+
+static bool beginOutFrame() {
+  if (!interfacesInited) return false;  // network not initialised
+  if (outPacket == nullptr) {
+    outPacket = (byte*) malloc(OUT_PACKET_LEN);
+    if (outPacket == nullptr) return false;
+  }
+  if (!netFrameStart) netFrameStart = micros() | 0x01; // 0 means no frame in progress
+  return true;
+}
+
 //
-// Send real time UDP updates to the specified client
+// Send pixels start to start+length-1 of buffer as DDP, using the DDP channel offset so that a partial frame can be sent
+// push - the receiver displays the frame after this range (ignored in sync mode, see realtimeBroadcastSync())
 //
-// type   - protocol type (0=DDP, 1=E1.31, 2=ArtNet)
-// client - the IP address to send to
-// length - the number of pixels
-// buffer - a buffer of at least length*4 bytes long
-// isRGBW - true if the buffer contains 4 components per pixel
+uint8_t realtimeBroadcastDDP(IPAddress client, uint16_t start, uint16_t length, byte *buffer, uint8_t bri, bool isRGBW, bool push) {
+  if (!beginOutFrame()) return 1;
+
+  // calclate the number of UDP packets we need to send
+  uint16_t channelCount = length * 3; // 1 channel for every R,G,B value
+  uint16_t packetCount = channelCount / DDP_CHANNELS_PER_PACKET;
+  if (channelCount % DDP_CHANNELS_PER_PACKET) {
+    packetCount++;
+  }
 
-uint8_t sequenceNumber = 0; // this needs to be shared across all outputs
+  // there are 3 channels per RGB pixel
+  uint32_t channel = start * 3;
+  // the current position in the buffer 
+  uint32_t bufferOffset = start * (isRGBW ? 4 : 3);
 
-uint8_t realtimeBroadcast(uint8_t type, IPAddress client, uint16_t length, uint8_t *buffer, uint8_t bri, bool isRGBW)  {
-  if (!interfacesInited) return 1;  // network not initialised
+  for (uint16_t currentPacket = 0; currentPacket < packetCount; currentPacket++) {
+    if (sequenceNumber > 15) sequenceNumber = 0;
 
-  WiFiUDP ddpUdp;
+    // the amount of data is AFTER the header in the current packet
+    uint16_t packetSize = DDP_CHANNELS_PER_PACKET;
 
-  switch (type) {
-    case 0: // DDP
-    {
-      // calclate the number of UDP packets we need to send
-      uint16_t channelCount = length * 3; // 1 channel for every R,G,B value
-      uint16_t packetCount = channelCount / DDP_CHANNELS_PER_PACKET;
+    uint8_t flags = DDP_FLAGS1_VER1;
+    bool lastPacket = (currentPacket == (packetCount - 1));
+    if (lastPacket) {
+      // last packet, set the push flag unless a broadcast push follows once all outputs have sent their data
+      if (push && !netOutputSync) flags = DDP_FLAGS1_VER1 | DDP_FLAGS1_PUSH;
       if (channelCount % DDP_CHANNELS_PER_PACKET) {
-        packetCount++;
+        packetSize = channelCount % DDP_CHANNELS_PER_PACKET;
       }
+    }
 
-      // there are 3 channels per RGB pixel
-      uint32_t channel = 0; // TODO: allow specifying the start channel
-      // the current position in the buffer 
-      uint16_t bufferOffset = 0;
-
-      for (uint16_t currentPacket = 0; currentPacket < packetCount; currentPacket++) {
-        if (sequenceNumber > 15) sequenceNumber = 0;
+    // write the header
+    outPacket[0] = flags;
+    outPacket[1] = sequenceNumber++ & 0x0F; // sequence may be unnecessary unless we are sending twice (as requested in Sync settings)
+    outPacket[2] = 0;
+    outPacket[3] = DDP_ID_DISPLAY;
+    // data offset in bytes, 32-bit number, MSB first
+    outPacket[4] = 0xFF & (channel >> 24);
+    outPacket[5] = 0xFF & (channel >> 16);
+    outPacket[6] = 0xFF & (channel >>  8);
+    outPacket[7] = 0xFF & (channel      );
+    // data length in bytes, 16-bit number, MSB first
+    outPacket[8] = 0xFF & (packetSize >> 8);
+    outPacket[9] = 0xFF & (packetSize     );
+
+    // write the colors
+    byte* data = outPacket + DDP_HEADER_LEN;
+    for (uint16_t i = 0; i < packetSize; i += 3) {
+      data[i]   = scale8(buffer[bufferOffset++], bri); // R
+      data[i+1] = scale8(buffer[bufferOffset++], bri); // G
+      data[i+2] = scale8(buffer[bufferOffset++], bri); // B
+      if (isRGBW) bufferOffset++;
+    }
 
-        if (!ddpUdp.beginPacket(client, DDP_DEFAULT_PORT)) {  // port defined in ESPAsyncE131.h
-          DEBUG_PRINTLN(F("WiFiUDP.beginPacket returned an error"));
-          return 1; // problem
-        }
+    if (!sendOutPacket(client, DDP_DEFAULT_PORT, DDP_HEADER_LEN + packetSize)) return 1; // problem
+    if (lastPacket && push && !netOutputSync) markLatch();
 
-        // the amount of data is AFTER the header in the current packet
-        uint16_t packetSize = DDP_CHANNELS_PER_PACKET;
+    channel += packetSize;
+  }
+  if (netOutputSync) netSyncPending |= NET_SYNC_DDP;
+  netDataSent = micros();
+  return 0;
+}
 
-        uint8_t flags = DDP_FLAGS1_VER1;
-        if (currentPacket == (packetCount - 1)) {
-          // last packet, set the push flag
-          // TODO: determine if we want to send an empty push packet to each destination after sending the pixel data
-          flags = DDP_FLAGS1_VER1 | DDP_FLAGS1_PUSH;
-          if (channelCount % DDP_CHANNELS_PER_PACKET) {
-            packetSize = channelCount % DDP_CHANNELS_PER_PACKET;
-          }
-        }
+//
+// Send real time UDP updates to the specified client
+//
+// type     - protocol type (0=DDP, 1=E1.31, 2=ArtNet)
+// client   - the IP address to send to (E1.31: a 239.x.x.x address sends each universe to its multicast group)
+// length   - the number of pixels
+// buffer   - a buffer of at least length*4 bytes long
+// isRGBW   - true if the buffer contains 4 components per pixel
+// universe - first universe (E1.31/ArtNet), the output spans consecutive universes of 170 RGB or 128 RGBW pixels
+// seq      - sequence numbers of each universe (E1.31/ArtNet)
+uint8_t realtimeBroadcast(uint8_t type, IPAddress client, uint16_t length, uint8_t *buffer, uint8_t bri, bool isRGBW, uint16_t universe, byte *seq)  {
+  switch (type) {
+    case 0: // DDP
+      return realtimeBroadcastDDP(client, 0, length, buffer, bri, isRGBW);
 
-        // write the header
-        /*0*/ddpUdp.write(flags);
-        /*1*/ddpUdp.write(sequenceNumber++ & 0x0F); // sequence may be unnecessary unless we are sending twice (as requested in Sync settings)
-        /*2*/ddpUdp.write(0);
-        /*3*/ddpUdp.write(DDP_ID_DISPLAY);
-        // data offset in bytes, 32-bit number, MSB first
-        /*4*/ddpUdp.write(0xFF & (channel >> 24));
-        /*5*/ddpUdp.write(0xFF & (channel >> 16));
-        /*6*/ddpUdp.write(0xFF & (channel >>  8));
-        /*7*/ddpUdp.write(0xFF & (channel      ));
-        // data length in bytes, 16-bit number, MSB first
-        /*8*/ddpUdp.write(0xFF & (packetSize >> 8));
-        /*9*/ddpUdp.write(0xFF & (packetSize     ));
-
-        // write the colors, the write write(const uint8_t *buffer, size_t size) 
-        // function is just a loop internally too
-        for (uint16_t i = 0; i < packetSize; i += 3) {
-          ddpUdp.write(scale8(buffer[bufferOffset++], bri)); // R
-          ddpUdp.write(scale8(buffer[bufferOffset++], bri)); // G
-          ddpUdp.write(scale8(buffer[bufferOffset++], bri)); // B
-          if (isRGBW) bufferOffset++;
+    case 1: //E1.31
+    case 2: //ArtNet
+    {
+      if (!beginOutFrame()) return 1;
+      // a universe only ever contains whole pixels
+      uint16_t channelsPerUniverse = isRGBW ? DMX_CHANNELS_PER_UNIVERSE : DMX_CHANNELS_PER_UNIVERSE -2;
+      uint32_t channelCount = (uint32_t)length * (isRGBW ? 4 : 3);
+      uint16_t universeCount = (channelCount + channelsPerUniverse -1) / channelsPerUniverse;
+      uint16_t headerLen = (type == 1) ? E131_HEADER_LEN : ARTNET_HEADER_LEN;
+      bool multicast = (type == 1 && client[0] == 239);
+      uint32_t bufferOffset = 0;
+
+      for (uint16_t u = 0; u < universeCount; u++) {
+        uint16_t uni = universe + u;
+        uint16_t dataLen = channelsPerUniverse;
+        if (channelCount - bufferOffset < dataLen) dataLen = channelCount - bufferOffset;
+
+        uint8_t sn = seq ? ++seq[u] : ++sequenceNumber;
+        if (type == 2 && !sn) sn = seq ? (seq[u] = 1) : (sequenceNumber = 1); // Art-Net sequence 0 disables reordering at the receiver
+
+        byte* data = outPacket + headerLen;
+        for (uint16_t i = 0; i < dataLen; i++) data[i] = scale8(buffer[bufferOffset++], bri);
+
+        if (type == 1) {
+          writeE131Header(outPacket, uni, sn, dataLen, netOutputSync ? universe : 0); // first universe doubles as sync address
+          IPAddress dest = multicast ? IPAddress(239, 255, uni >> 8, uni & 0xFF) : client;
+          if (!sendOutPacket(dest, E131_DEFAULT_PORT, headerLen + dataLen)) return 1;
+        } else {
+          if (dataLen & 0x01) data[dataLen++] = 0; // Art-Net needs an even number of channels
+          writeArtNetHeader(outPacket, uni, sn, dataLen);
+          if (!sendOutPacket(client, ARTNET_DEFAULT_PORT, headerLen + dataLen)) return 1;
         }
+      }
 
-        if (!ddpUdp.endPacket()) {            
-          DEBUG_PRINTLN(F("WiFiUDP.endPacket returned an error"));
-          return 1; // problem
+      if (!netOutputSync) {
+        markLatch();
+      } else if (type == 1) {
+        netSyncPending |= NET_SYNC_E131;
+        if (e131SyncCount < WLED_MAX_BUSSES) {
+          e131SyncIP[e131SyncCount] = multicast ? IPAddress(239, 255, universe >> 8, universe & 0xFF) : client;
+          e131SyncUniverse[e131SyncCount++] = universe;
         }
-
-        channel += packetSize;
+      } else {
+        netSyncPending |= NET_SYNC_ARTNET;
       }
     } break;
+  }
+  netDataSent = micros();
+  return 0;
+}
 
-    case 1: //E1.31
-    {
-    } break;
+//
+// Called by BusManager once all network busses have sent their data.
+// In sync mode, sends a DDP broadcast push, E1.31 sync and/or ArtSync packets so that all nodes display the frame together.
+// Updates the timing report: netOutTxUs is the time spent sending all data, netOutSkewUs the time between the first and last node latching the frame.
+//
+void realtimeBroadcastSync() {
+  if (!netFrameStart) return; // nothing was sent this frame
+
+  if (netSyncPending) {
+    IPAddress broadcastIp = ~uint32_t(Network.subnetMask()) | uint32_t(Network.gatewayIP());
+
+    if (netSyncPending & NET_SYNC_DDP) {
+      if (sequenceNumber > 15) sequenceNumber = 0;
+      memset(outPacket, 0, DDP_SYNCPACKET_LEN);
+      outPacket[0] = DDP_FLAGS1_VER1 | DDP_FLAGS1_PUSH;
+      outPacket[1] = sequenceNumber++ & 0x0F;
+      outPacket[3] = DDP_ID_DISPLAY;
+      if (sendOutPacket(broadcastIp, DDP_DEFAULT_PORT, DDP_SYNCPACKET_LEN)) markLatch();
+    }
 
-    case 2: //ArtNet
-    {
-    } break;
+    if (netSyncPending & NET_SYNC_E131) {
+      e131SyncSequence++;
+      for (uint8_t i = 0; i < e131SyncCount; i++) {
+        byte* p = outPacket;
+        memset(p, 0, E131_SYNCPACKET_LEN);
+        p[1] = 0x10;                                       //preamble size
+        memcpy_P(p + 4, E131_ACN_ID, sizeof(E131_ACN_ID));
+        p[16] = 0x70; p[17] = E131_SYNCPACKET_LEN - 16;
+        p[21] = 0x08;                                      //VECTOR_ROOT_E131_EXTENDED
+        writeE131Cid(p + 22);
+        p[38] = 0x70; p[39] = E131_SYNCPACKET_LEN - 38;
+        p[43] = 0x01;                                      //VECTOR_E131_EXTENDED_SYNCHRONIZATION
+        p[44] = e131SyncSequence;
+        p[45] = e131SyncUniverse[i] >> 8; p[46] = e131SyncUniverse[i] & 0xFF;
+        if (sendOutPacket(e131SyncIP[i], E131_DEFAULT_PORT, E131_SYNCPACKET_LEN)) markLatch();
+      }
+    }
+
+    if (netSyncPending & NET_SYNC_ARTNET) {
+      memcpy_P(outPacket, ARTNET_ID, sizeof(ARTNET_ID));
+      outPacket[8]  = ARTNET_OPCODE_OPSYNC & 0xFF;
+      outPacket[9]  = ARTNET_OPCODE_OPSYNC >> 8;
+      outPacket[10] = 0; outPacket[11] = 14;               //protocol version
+      outPacket[12] = 0; outPacket[13] = 0;                //aux
+      if (sendOutPacket(broadcastIp, ARTNET_DEFAULT_PORT, ARTNET_SYNCPACKET_LEN)) markLatch();
+    }
   }
-  return 0;
+
+  netOutTxUs   = netDataSent - netFrameStart;
+  netOutSkewUs = netLatched ? netLastLatch - netFirstLatch : 0;
+  netFrameStart = 0;
+  netSyncPending = 0;
+  e131SyncCount = 0;
+  netLatched = false;
 }
@@ -1,19 +1,36 @@
 #include "wled.h"
 #include "fcn_declare.h"
 #include "const.h"
+#ifdef ESP8266
+#include <coredecls.h>
+#endif
 
 //threading/network callback details: https://github.com/Aircoookie/WLED/pull/2336#discussion_r762276994
+//true in the main loop, false in async callbacks (SYS context on ESP8266, AsyncTCP task on ESP32)
+bool inLoopContext()
+{
+  #ifdef ESP8266
+  return can_yield();
+  #else
+  return xTaskGetCurrentTaskHandle() == loopTaskId;
+  #endif
+}
+
+//only the main loop waits for the buffer, async callbacks fail immediately if it is in use
+//(state changes from async callbacks should go through queueJsonCommand() instead)
 bool requestJSONBufferLock(uint8_t module)
 {
   unsigned long now = millis();
 
-  while (jsonBufferLock && millis()-now < 1000) delay(1); // wait for a second for buffer lock
+  if (inLoopContext()) {
+    while (jsonBufferLock && millis()-now < 1000) delay(1); // wait for a second for buffer lock
+  }
 
-  if (millis()-now >= 1000) {
+  if (jsonBufferLock) {
     DEBUG_PRINT(F("ERROR: Locking JSON buffer failed! ("));
     DEBUG_PRINT(jsonBufferLock);
     DEBUG_PRINTLN(")");
-    return false; // waiting time-outed
+    return false; // buffer in use
   }
 
   jsonBufferLock = module ? module : 255;
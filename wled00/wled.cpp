@@ -129,6 +129,7 @@ void WLED::loop()
   handleConnection();
   handleSerial();
   handleNotifications();
+  handleJsonCommands();
   handleTransitions();
 #ifdef WLED_ENABLE_DMX
   handleDMX();
@@ -157,6 +158,11 @@ void WLED::loop()
     closeFile();
     yield();
   }
+  if (doSerializeConfig) {
+    doSerializeConfig = false;
+    serializeConfig();
+  }
+  handlePresetStore();
 
   if (!realtimeMode || realtimeOverride)  // block stuff if WARLS/Adalight is enabled
   {
@@ -184,6 +190,7 @@ void WLED::loop()
       delay(1); //required to make sure ESP enters modem sleep (see #1184)
 #endif
   }
+  updateStateRevision();
   yield();
 #ifdef ESP8266
   MDNS.update();
@@ -274,6 +281,12 @@ void WLED::loop()
 
 void WLED::setup()
 {
+  #ifdef ARDUINO_ARCH_ESP32
+  loopTaskId = xTaskGetCurrentTaskHandle();
+  stateBootId = esp_random();
+  #else
+  stateBootId = RANDOM_REG32;
+  #endif
   #if defined(ARDUINO_ARCH_ESP32) && defined(WLED_DISABLE_BROWNOUT_DET)
   WRITE_PERI_REG(RTC_CNTL_BROWN_OUT_REG, 0); //disable brownout detection
   #endif
@@ -329,7 +342,10 @@ void WLED::setup()
   if (!fsinit) {
     DEBUGFS_PRINTLN(F("FS failed!"));
     errorFlag = ERR_FS_BEGIN;
-  } else deEEP();
+  } else {
+    deEEP();
+    initPresetStore();
+  }
   updateFSInfo();
 
   DEBUG_PRINTLN(F("Reading config"));
@@ -667,7 +683,7 @@ void WLED::initInterfaces()
 #ifndef WLED_DISABLE_BLYNK
   initBlynk(blynkApiKey, blynkHost, blynkPort);
 #endif
-  e131.begin(e131Multicast, e131Port, e131Universe, E131_MAX_UNIVERSE_COUNT);
+  e131.begin(e131Multicast, e131Port, e131Universe, min(e131UniverseCount(), (uint16_t)E131_MAX_UNIVERSE_COUNT));
   ddp.begin(false, DDP_DEFAULT_PORT);
   reconnectHue();
   initMqtt();
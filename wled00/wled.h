@@ -280,6 +280,7 @@ WLED_GLOBAL byte bootPreset   _INIT(0);                   // save preset to load
 WLED_GLOBAL bool autoSegments _INIT(false);
 WLED_GLOBAL bool correctWB _INIT(false); //CCT color correction of RGB color
 WLED_GLOBAL bool cctFromRgb _INIT(false); //CCT is calculated from RGB instead of using seg.cct
+WLED_GLOBAL bool netOutputSync _INIT(false); //network busses send all data first, then latch all nodes with one push/sync packet
 
 WLED_GLOBAL byte col[]    _INIT_N(({ 255, 160, 0, 0 }));  // current RGB(W) primary color. col[] should be updated if you want to change the color.
 WLED_GLOBAL byte colSec[] _INIT_N(({ 0, 0, 0, 0 }));      // current RGB(W) secondary color
@@ -346,9 +347,9 @@ WLED_GLOBAL uint16_t e131Port _INIT(5568);                        // DMX in port
 WLED_GLOBAL byte DMXMode _INIT(DMX_MODE_MULTIPLE_RGB);            // DMX mode (s.a.)
 WLED_GLOBAL uint16_t DMXAddress _INIT(1);                         // DMX start address of fixture, a.k.a. first Channel [for E1.31 (sACN) protocol]
 WLED_GLOBAL byte DMXOldDimmer _INIT(0);                           // only update brightness on change
-WLED_GLOBAL byte e131LastSequenceNumber[E131_MAX_UNIVERSE_COUNT]; // to detect packet loss
 WLED_GLOBAL bool e131Multicast _INIT(false);                      // multicast or unicast
 WLED_GLOBAL bool e131SkipOutOfSequence _INIT(false);              // freeze instead of flickering
+WLED_GLOBAL uint16_t e131FrameTimeout _INIT(E131_FRAME_TIMEOUT);   // ms to wait for all universes of a frame (or its sync packet) before showing it
 
 WLED_GLOBAL bool mqttEnabled _INIT(false);
 WLED_GLOBAL char mqttDeviceTopic[33] _INIT("");            // main MQTT topic (individual per device, default is wled/mac)
@@ -540,11 +541,15 @@ WLED_GLOBAL IPAddress realtimeIP _INIT_N(((0, 0, 0, 0)));
 WLED_GLOBAL unsigned long realtimeTimeout _INIT(0);
 WLED_GLOBAL uint8_t tpmPacketCount _INIT(0);
 WLED_GLOBAL uint16_t tpmPayloadFrameSize _INIT(0);
+WLED_GLOBAL uint32_t netOutTxUs _INIT(0);     // time needed to send the last frame to all network busses
+WLED_GLOBAL uint32_t netOutSkewUs _INIT(0);   // time between first and last network node latching the last frame
 
 // mqtt
 WLED_GLOBAL unsigned long lastMqttReconnectAttempt _INIT(0);
 WLED_GLOBAL unsigned long lastInterfaceUpdate _INIT(0);
 WLED_GLOBAL byte interfaceUpdateCallMode _INIT(CALL_MODE_INIT);
+WLED_GLOBAL uint32_t stateRevision _INIT(0);   // incremented on every state change (/json/rev, ETag of /json/state)
+WLED_GLOBAL uint32_t stateBootId _INIT(0);     // random per boot, so ETags of a previous boot do not match
 WLED_GLOBAL char mqttStatusTopic[40] _INIT("");        // this must be global because of async handlers
 
 // alexa udp
@@ -581,6 +586,7 @@ WLED_GLOBAL size_t fsBytesTotal _INIT(0);
 WLED_GLOBAL unsigned long presetsModifiedTime _INIT(0L);
 WLED_GLOBAL JsonDocument* fileDoc;
 WLED_GLOBAL bool doCloseFile _INIT(false);
+WLED_GLOBAL bool doImportPresets _INIT(false); // an uploaded presets.json is imported into the preset store from the main loop
 
 // presets
 WLED_GLOBAL byte currentPreset _INIT(0);
@@ -591,6 +597,7 @@ WLED_GLOBAL String messageHead, messageSub;
 WLED_GLOBAL byte optionType;
 
 WLED_GLOBAL bool doReboot _INIT(false);        // flag to initiate reboot from async handlers
+WLED_GLOBAL bool doSerializeConfig _INIT(false); // flag to save the configuration from the main loop (async handlers must not wait for the JSON buffer)
 WLED_GLOBAL bool doPublishMqtt _INIT(false);
 
 // server library objects
@@ -607,6 +614,10 @@ WLED_GLOBAL WiFiUDP ntpUdp;
 WLED_GLOBAL ESPAsyncE131 e131 _INIT_N(((handleE131Packet)));
 WLED_GLOBAL ESPAsyncE131 ddp  _INIT_N(((handleE131Packet)));
 WLED_GLOBAL bool e131NewData _INIT(false);
+WLED_GLOBAL uint32_t ddpTimedFrames _INIT(0); // DDP frames with timecode received
+WLED_GLOBAL uint32_t ddpLateFrames _INIT(0);  // DDP frames with timecode that arrived late or were superseded before playout
+WLED_GLOBAL uint16_t ddpMaxLate _INIT(0);     // most ms a DDP frame arrived after its timecode
+WLED_GLOBAL uint8_t  ddpJitterDepth _INIT(0); // DDP frames waiting for playout
 
 // led fx library object
 WLED_GLOBAL BusManager busses _INIT(BusManager());
@@ -623,6 +634,9 @@ WLED_GLOBAL UsermodManager usermods _INIT(UsermodManager());
 WLED_GLOBAL StaticJsonDocument<JSON_BUFFER_SIZE> doc;
 #endif
 WLED_GLOBAL volatile uint8_t jsonBufferLock _INIT(0);
+#ifdef ARDUINO_ARCH_ESP32
+WLED_GLOBAL TaskHandle_t loopTaskId _INIT(nullptr); //only the main loop may wait for the JSON buffer lock
+#endif
 
 // enable additional debug output
 #ifdef WLED_DEBUG
@@ -1,26 +1,28 @@
 #include "wled.h"
+#include "serial_parser.h"
 
 /*
  * Adalight and TPM2 handler
  */
 
-enum class AdaState {
-  Header_A,
-  Header_d,
-  Header_a,
-  Header_CountHi,
-  Header_CountLo,
-  Header_CountCheck,
-  Data_Red,
-  Data_Green,
-  Data_Blue,
-  TPM2_Header_Type,
-  TPM2_Header_CountHi,
-  TPM2_Header_CountLo,
-};
-
 uint16_t currentBaud = 1152; //default baudrate 115200 (divided by 100)
 
+#ifdef WLED_ENABLE_ADALIGHT
+static SerialFrameParser adaParser;
+
+//commits a complete frame with one bulk write
+static void showAdaFrame()
+{
+  if (!realtimeMode && bri == 0) strip.setBrightness(briLast);
+  realtimeLock(realtimeTimeoutMs, REALTIME_MODE_ADALIGHT);
+  realtimeStatsPacket(REALTIME_MODE_ADALIGHT, IPAddress());
+  if (realtimeOverride) return;
+  setRealtimePixels(0, adaParser.frame(), adaParser.frameLeds(), RT_PIXEL_RGB | realtimeGamma());
+  strip.show();
+  realtimeStatsShow();
+}
+#endif
+
 void updateBaudRate(uint32_t rate){
   uint16_t rate100 = rate/100;
   if (rate100 == currentBaud || rate100 < 96) return;
@@ -39,150 +41,107 @@ void handleSerial()
   if (pinManager.isPinAllocated(3)) return;
   
   #ifdef WLED_ENABLE_ADALIGHT
-  static auto state = AdaState::Header_A;
-  static uint16_t count = 0;
-  static uint16_t pixel = 0;
-  static byte check = 0x00;
-  static byte red   = 0x00;
-  static byte green = 0x00;
+  if (adaParser.idle() && !realtimeMode) adaParser.freeBuffer(); //free the frame buffer once realtime ended
+  adaParser.setCapacity(realtimeFrameLeds() * 3); //data beyond the strip is received but not stored
 
-  uint16_t nBytes = 0;
-  
   while (Serial.available() > 0)
   {
-    yield();
+    uint8_t event;
+    uint32_t left = adaParser.dataLeft();
+    if (left) { //read pixel data in blocks instead of byte by byte
+      byte block[128];
+      size_t n = Serial.available();
+      if (n > left) n = left;
+      if (n > sizeof(block)) n = sizeof(block);
+      adaParser.parse(block, Serial.readBytes(block, n), event);
+      if (event == SerialFrameParser::SP_FRAME) showAdaFrame();
+      else if (!Serial.available()) yield();
+      continue;
+    }
+
     byte next = Serial.peek();
-    switch (state) {
-      case AdaState::Header_A:
-        if (next == 'A') state = AdaState::Header_d;
-        else if (next == 0xC9) { //TPM2 start byte
-          state = AdaState::TPM2_Header_Type;
+    if (adaParser.parse(&next, 1, event)) { //Adalight or TPM2 header
+      if (event == SerialFrameParser::SP_TPM2_PING) Serial.write(0xAC);
+      Serial.read();
+      continue;
+    }
+    //command, other bytes are discarded
+    if (next == 'I') {
+      handleImprovPacket();
+      return;
+    } else if (next == 'v') {
+      Serial.print("WLED"); Serial.write(' '); Serial.println(VERSION);
+ 
+    } else if (next == 0xB0) {updateBaudRate( 115200);
+    } else if (next == 0xB1) {updateBaudRate( 230400);
+    } else if (next == 0xB2) {updateBaudRate( 460800);
+    } else if (next == 0xB3) {updateBaudRate( 500000);
+    } else if (next == 0xB4) {updateBaudRate( 576000);
+    } else if (next == 0xB5) {updateBaudRate( 921600);
+    } else if (next == 0xB6) {updateBaudRate(1000000);
+    } else if (next == 0xB7) {updateBaudRate(1500000);
+    
+    } else if (next == 'l') { //RGB(W) LED data return as JSON array. Slow, but easy to use on the other end.
+      if (!pinManager.isPinAllocated(1) || pinManager.getPinOwner(1) == PinOwner::DebugOut){
+        uint16_t used = strip.getLengthTotal();
+        Serial.write('[');
+        for (uint16_t i=0; i<used; i+=1) {
+          Serial.print(strip.getPixelColor(i));
+          if (i != used-1) Serial.write(',');
         }
-        else if (next == 'I') {
-          handleImprovPacket();
-          return;
-        } else if (next == 'v') {
-          Serial.print("WLED"); Serial.write(' '); Serial.println(VERSION);
-     
-        } else if (next == 0xB0) {updateBaudRate( 115200);
-        } else if (next == 0xB1) {updateBaudRate( 230400);
-        } else if (next == 0xB2) {updateBaudRate( 460800);
-        } else if (next == 0xB3) {updateBaudRate( 500000);
-        } else if (next == 0xB4) {updateBaudRate( 576000);
-        } else if (next == 0xB5) {updateBaudRate( 921600);
-        } else if (next == 0xB6) {updateBaudRate(1000000);
-        } else if (next == 0xB7) {updateBaudRate(1500000);
-        
-        } else if (next == 'l') { //RGB(W) LED data return as JSON array. Slow, but easy to use on the other end.
-          if (!pinManager.isPinAllocated(1) || pinManager.getPinOwner(1) == PinOwner::DebugOut){
-            uint16_t used = strip.getLengthTotal();
-            Serial.write('[');
-            for (uint16_t i=0; i<used; i+=1) {
-              Serial.print(strip.getPixelColor(i));
-              if (i != used-1) Serial.write(',');
-            }
-            Serial.println("]");
-          }  
-        } else if (next == 'L') { //RGB LED data returned as bytes in tpm2 format. Faster, and slightly less easy to use on the other end.
-          if (!pinManager.isPinAllocated(1) || pinManager.getPinOwner(1) == PinOwner::DebugOut) {
-            Serial.write(0xC9); Serial.write(0xDA);
-            uint16_t used = strip.getLengthTotal();
-            uint16_t len = used*3;
-            Serial.write((len << 8) & 0xFF);
-            Serial.write( len       & 0xFF);
-            for (uint16_t i=0; i < used; i++) {
-              uint32_t c = strip.getPixelColor(i);
-              Serial.write(qadd8(W(c), R(c))); //R, add white channel to RGB channels as a simple RGBW -> RGB map
-              Serial.write(qadd8(W(c), G(c))); //G
-              Serial.write(qadd8(W(c), B(c))); //B
-            }
-            Serial.write(0x36); Serial.write('\n');
-          }
-        } else if (next == '{') { //JSON API
-          bool verboseResponse = false;
-          #ifdef WLED_USE_DYNAMIC_JSON
-          DynamicJsonDocument doc(JSON_BUFFER_SIZE);
-          #else
-          if (!requestJSONBufferLock(16)) return;
-          #endif
-          Serial.setTimeout(100);
-          DeserializationError error = deserializeJson(doc, Serial);
-          if (error) {
-            releaseJSONBufferLock();
-            return;
-          }
-          verboseResponse = deserializeState(doc.as<JsonObject>());
-          //only send response if TX pin is unused for other purposes
-          if (verboseResponse && (!pinManager.isPinAllocated(1) || pinManager.getPinOwner(1) == PinOwner::DebugOut)) {
-            doc.clear();
-            JsonObject state = doc.createNestedObject("state");
-            serializeState(state);
-            JsonObject info  = doc.createNestedObject("info");
-            serializeInfo(info);
-
-            serializeJson(doc, Serial);
-            Serial.println();
-          }
-          releaseJSONBufferLock();
+        Serial.println("]");
+      }  
+    } else if (next == 'L') { //RGB LED data returned as bytes in tpm2 format. Faster, and slightly less easy to use on the other end.
+      if (!pinManager.isPinAllocated(1) || pinManager.getPinOwner(1) == PinOwner::DebugOut) {
+        uint16_t len = strip.getLengthTotal()*3;
+        byte* buf = (byte*)malloc(len +5);
+        if (buf) {
+          bool rle = false;
+          buf[0] = 0xC9; buf[1] = 0xDA;
+          buf[2] = (len >> 8) & 0xFF;
+          buf[3] =  len       & 0xFF;
+          writeLiveLeds(buf +4, len, rle);
+          buf[len +4] = 0x36;
+          Serial.write(buf, len +5);
+          Serial.write('\n');
+          free(buf);
         }
-        break;
-      case AdaState::Header_d:
-        if (next == 'd') state = AdaState::Header_a;
-        else             state = AdaState::Header_A;
-        break;
-      case AdaState::Header_a:
-        if (next == 'a') state = AdaState::Header_CountHi;
-        else             state = AdaState::Header_A;
-        break;
-      case AdaState::Header_CountHi:
-        pixel = 0;
-        count = next * 0x100;
-        check = next;
-        state = AdaState::Header_CountLo;
-        break;
-      case AdaState::Header_CountLo:
-        count += next + 1;
-        check = check ^ next ^ 0x55;
-        state = AdaState::Header_CountCheck;
-        break;
-      case AdaState::Header_CountCheck:
-        if (check == next) state = AdaState::Data_Red;
-        else               state = AdaState::Header_A;
-        break;
-      case AdaState::TPM2_Header_Type:
-        state = AdaState::Header_A; //(unsupported) TPM2 command or invalid type
-        if (next == 0xDA) state = AdaState::TPM2_Header_CountHi; //TPM2 data
-        else if (next == 0xAA) Serial.write(0xAC); //TPM2 ping
-        break;
-      case AdaState::TPM2_Header_CountHi:
-        pixel = 0;
-        count = (next * 0x100) /3;
-        state = AdaState::TPM2_Header_CountLo;
-        break;
-      case AdaState::TPM2_Header_CountLo:
-        count += next /3;
-        state = AdaState::Data_Red;
-        break;
-      case AdaState::Data_Red:
-        red   = next;
-        state = AdaState::Data_Green;
-        break;
-      case AdaState::Data_Green:
-        green = next;
-        state = AdaState::Data_Blue;
-        break;
-      case AdaState::Data_Blue:
-        byte blue  = next;
-        if (!realtimeOverride) setRealtimePixel(pixel++, red, green, blue, 0);
-        if (--count > 0) state = AdaState::Data_Red;
-        else {
-          if (!realtimeMode && bri == 0) strip.setBrightness(briLast);
-          realtimeLock(realtimeTimeoutMs, REALTIME_MODE_ADALIGHT);
-
-          if (!realtimeOverride) strip.show();
-          state = AdaState::Header_A;
+      }
+    } else if (next == 'b' || next == 'B') { //binary LED snapshot of the full frame, 'B' run-length encoded
+      if (!pinManager.isPinAllocated(1) || pinManager.getPinOwner(1) == PinOwner::DebugOut) {
+        uint32_t size = liveLedsBinarySize();
+        byte* buf = (byte*)malloc(size);
+        if (buf) {
+          Serial.write(buf, serializeLiveLedsBinary(buf, size, next == 'B'));
+          free(buf);
         }
-        break;
+      }
+    } else if (next == '{') { //JSON API
+      bool verboseResponse = false;
+      #ifdef WLED_USE_DYNAMIC_JSON
+      DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+      #else
+      if (!requestJSONBufferLock(16)) return;
+      #endif
+      Serial.setTimeout(100);
+      DeserializationError error = deserializeJson(doc, Serial);
+      if (error) {
+        releaseJSONBufferLock();
+        return;
+      }
+      verboseResponse = deserializeState(doc.as<JsonObject>());
+      //only send response if TX pin is unused for other purposes
+      if (verboseResponse && (!pinManager.isPinAllocated(1) || pinManager.getPinOwner(1) == PinOwner::DebugOut)) {
+        doc.clear();
+        JsonObject state = doc.createNestedObject("state");
+        serializeState(state);
+        JsonObject info  = doc.createNestedObject("info");
+        serializeInfo(info);
+
+        serializeJson(doc, Serial);
+        Serial.println();
+      }
+      releaseJSONBufferLock();
     }
     Serial.read(); //discard the byte
   }
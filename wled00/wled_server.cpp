@@ -31,6 +31,7 @@ void handleUpload(AsyncWebServerRequest *request, const String& filename, size_t
   }
   if(final){
     request->_tempFile.close();
+    if (filename == "/presets.json") doImportPresets = true; //replaces the preset store
     request->send(200, "text/plain", F("File Uploaded!"));
   }
 }
@@ -52,6 +53,32 @@ bool captivePortal(AsyncWebServerRequest *request)
   return false;
 }
 
+//true if the JSON (or MessagePack) body contains a "v" key, the response has to contain the resulting state
+static bool hasVerboseKey(const char* body, size_t len, bool msgPack)
+{
+  for (size_t i = 0; i +2 < len; i++) {
+    if (msgPack && body[i] == (char)0xA1 && body[i+1] == 'v') return true; //fixstr of length 1
+    if (body[i] == '"' && body[i+1] == 'v' && body[i+2] == '"') return true;
+  }
+  return false;
+}
+
+//POST /json body (JSON text or MessagePack), state and config changes are applied by the main loop in the order they arrived
+static void handleJsonPost(AsyncWebServerRequest *request, bool msgPack)
+{
+  bool isConfig = request->url().indexOf("cfg") > -1;
+  size_t len = request->contentLength();
+  byte source = isConfig ? JSON_CMD_CFG : JSON_CMD_STATE;
+  if (msgPack) source |= JSON_CMD_MSGPACK;
+  bool verboseResponse = !isConfig && hasVerboseKey((const char*)request->_tempObject, len, msgPack);
+  if (!isConfig && !verboseResponse) {
+    if (queueJsonCommand((const char*)request->_tempObject, len, source)) request->send(200, "application/json", F("{\"success\":true}"));
+    else request->send(503, "application/json", F("{\"error\":\"Busy\"}"));
+    return;
+  }
+  serveJsonCommand(request, (const char*)request->_tempObject, len, source, verboseResponse); //if JSON contains "v" or is config, reply once applied
+}
+
 void initServer()
 {
   //CORS compatiblity
@@ -102,46 +129,24 @@ void initServer()
     serveJson(request);
   });
 
-  AsyncCallbackJsonWebHandler* handler = new AsyncCallbackJsonWebHandler("/json", [](AsyncWebServerRequest *request) {
-    bool verboseResponse = false;
-    bool isConfig = false;
-    { //scope JsonDocument so it releases its buffer
-      #ifdef WLED_USE_DYNAMIC_JSON
-      DynamicJsonDocument doc(JSON_BUFFER_SIZE);
-      #else
-      if (!requestJSONBufferLock(14)) return;
-      #endif
-
-      DeserializationError error = deserializeJson(doc, (uint8_t*)(request->_tempObject));
-      JsonObject root = doc.as<JsonObject>();
-      if (error || root.isNull()) {
-        releaseJSONBufferLock();
-        request->send(400, "application/json", F("{\"error\":9}"));
-        return;
-      }
-      const String& url = request->url();
-      isConfig = url.indexOf("cfg") > -1;
-      if (!isConfig) {
-        #ifdef WLED_DEBUG
-          DEBUG_PRINTLN(F("Serialized HTTP"));
-          serializeJson(root,Serial);
-          DEBUG_PRINTLN();
-        #endif
-        verboseResponse = deserializeState(root);
-      } else {
-        verboseResponse = deserializeConfig(root); //use verboseResponse to determine whether cfg change should be saved immediately
-      }
-      releaseJSONBufferLock();
+  //MessagePack bodies get their own handler, registered first so the JSON handler never sees them
+  server.on("/json", HTTP_POST, [](AsyncWebServerRequest *request) {
+    if (request->_tempObject == nullptr) {
+      request->send(request->contentLength() >= JSON_MAX_POST_SIZE ? 413 : 400);
+      return;
     }
-    if (verboseResponse) {
-      if (!isConfig) {
-        serveJson(request); return; //if JSON contains "v"
-      } else {
-        serializeConfig(); //Save new settings to FS
-      }
-    } 
-    request->send(200, "application/json", F("{\"success\":true}"));
+    handleJsonPost(request, true);
+  }, nullptr, [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (!index && total && total < JSON_MAX_POST_SIZE && request->_tempObject == nullptr) request->_tempObject = malloc(total);
+    if (request->_tempObject != nullptr) memcpy((uint8_t*)request->_tempObject + index, data, len); //freed with the request
+  }).setFilter([](AsyncWebServerRequest *request) {
+    return request->contentType().indexOf(F("msgpack")) >= 0;
+  });
+
+  AsyncCallbackJsonWebHandler* handler = new AsyncCallbackJsonWebHandler("/json", [](AsyncWebServerRequest *request) {
+    handleJsonPost(request, false);
   });
+  handler->setMaxContentLength(JSON_MAX_POST_SIZE);
   server.addHandler(handler);
 
   server.on("/version", HTTP_GET, [](AsyncWebServerRequest *request){
@@ -266,10 +271,21 @@ void initServer()
       return;
     }
     
-    if(handleSet(request, request->url())) return;
+    //HTTP API, applied by the main loop between frames like the JSON API
+    const String& url = request->url();
+    if (strstr(url.c_str(), "win")) {
+      if (url.indexOf(F("IN")) < 0) serveApiCommand(request, url.c_str(), url.length());
+      else if (queueJsonCommand(url.c_str(), url.length(), JSON_CMD_API, 1)) request->send(200); //internal call, no XML response
+      else request->send(503, "text/plain", F("Busy"));
+      return;
+    }
     #ifndef WLED_DISABLE_ALEXA
     if(espalexa.handleAlexaApiCall(request)) return;
     #endif
+    if (request->url() == "/presets.json") { //generated from the preset store
+      servePresetsJson(request);
+      return;
+    }
     if(handleFileRead(request, request->url())) return;
     request->send_P(404, "text/html", PAGE_404);
   });
@@ -431,7 +447,10 @@ void serveSettings(AsyncWebServerRequest* request, bool post)
   }
 
   if (post) { //settings/set POST request, saving
-    if (subPage != 1 || !(wifiLock && otaLock)) handleSettingsSet(request, subPage);
+    if ((subPage != 1 || !(wifiLock && otaLock)) && !handleSettingsSet(request, subPage)) {
+      serveMessage(request, 503, F("Busy"), F("Settings not saved, please try again."), 254);
+      return;
+    }
 
     char s[32];
     char s2[45] = "";
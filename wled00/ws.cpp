@@ -6,19 +6,188 @@
 #ifdef WLED_ENABLE_WEBSOCKETS
 
 uint16_t wsLiveClientId = 0;
+bool wsLiveFull = false;
 unsigned long wsLastLiveTime = 0;
 //uint8_t* wsFrameBuffer = nullptr;
 
 #define WS_LIVE_INTERVAL 40
+#define WS_LIVE_INTERVAL_MAX 1000 //slowest rate of the full resolution stream if the client can not keep up
+#define WS_LIVE_KEYFRAME 5000     //full resolution stream sends a complete frame at least this often
+
+static byte* wsLivePrev = nullptr;          //RGB data of the last full resolution frame sent
+static uint16_t wsLivePrevLeds = 0;         //LED count of wsLivePrev, 0 if the next frame must be a keyframe
+static uint16_t wsLiveInterval = WS_LIVE_INTERVAL;
+static unsigned long wsLastKeyframe = 0;
+
+//binary realtime messages are copied by the AsyncTCP callback and applied by handleWs(), like UDP realtime in the loop
+#define WS_RT_SLOTS 4
+static struct {
+  byte* data;
+  uint16_t len;
+  uint32_t client;
+  IPAddress ip;
+} wsRtQueue[WS_RT_SLOTS];
+static volatile uint8_t wsRtHead = 0, wsRtTail = 0; //single producer (async), single consumer (main loop)
+static bool wsShowPending = false;          //realtime pixels applied, not shown yet
+static volatile bool wsAckPending = false;  //frame was shown, acknowledge once the client's send queue is empty
+static uint32_t wsRealtimeClientId = 0;
+
+#define WS_UPDATE_INTERVAL 100 //state broadcasts are coalesced to at most one per interval
+#define WS_STATE_CLIENTS 8     //AsyncWebSocket accepts no more than 8 clients
+
+//clients receiving state updates, a client is only sent the latest state once its send queue is empty
+static struct {
+  uint32_t id;  //0: slot free
+  bool delta;   //client asked for state deltas ({"delta":true})
+  bool pending; //state changed since the last update sent to this client
+  bool resync;  //gets the full state next (just connected, or a delta client that missed an update)
+} wsClients[WS_STATE_CLIENTS];
+static bool wsStatePending = false;
+static unsigned long wsLastStateTime = 0;
+
+//segments as of the last delta broadcast. The name is only kept as a hash,
+//the segment's name buffer may be freed or replaced after the copy was taken
+static struct {
+  WS2812FX::Segment seg; //name is always nullptr
+  uint32_t nameHash;
+} wsSentSegs[MAX_NUM_SEGMENTS];
+
+//message buffers are created here instead of ws.makeBuffer() and deleted once no client queue references them.
+//Buffers are handed out locked, the caller unlocks them after queueing them to its clients.
+#define WS_BUFFERS 8
+static AsyncWebSocketMessageBuffer* wsBuffers[WS_BUFFERS];
+#ifdef ARDUINO_ARCH_ESP32
+static portMUX_TYPE wsBufferMux = portMUX_INITIALIZER_UNLOCKED; //buffers are made in the loop and in the AsyncTCP task
+#define WS_BUFFERS_ENTER portENTER_CRITICAL(&wsBufferMux)
+#define WS_BUFFERS_EXIT  portEXIT_CRITICAL(&wsBufferMux)
+#else
+#define WS_BUFFERS_ENTER
+#define WS_BUFFERS_EXIT
+#endif
+
+//deletes the buffers all clients are done with
+static void releaseWsBuffers()
+{
+  AsyncWebSocketMessageBuffer* done[WS_BUFFERS];
+  uint8_t n = 0;
+  WS_BUFFERS_ENTER;
+  for (uint8_t i = 0; i < WS_BUFFERS; i++) {
+    if (!wsBuffers[i] || !wsBuffers[i]->canDelete()) continue;
+    done[n++] = wsBuffers[i];
+    wsBuffers[i] = nullptr;
+  }
+  WS_BUFFERS_EXIT;
+  while (n) delete done[--n];
+}
+
+//locked message buffer of len bytes, nullptr if out of memory or too many messages are in flight
+static AsyncWebSocketMessageBuffer* makeWsBuffer(size_t len)
+{
+  releaseWsBuffers();
+  AsyncWebSocketMessageBuffer* buffer = new AsyncWebSocketMessageBuffer(len);
+  if (!buffer) return nullptr;
+  if (!buffer->get()) {
+    delete buffer;
+    return nullptr;
+  }
+  buffer->lock();
+  int8_t slot = -1;
+  WS_BUFFERS_ENTER;
+  for (uint8_t i = 0; i < WS_BUFFERS; i++) {
+    if (wsBuffers[i]) continue;
+    wsBuffers[i] = buffer;
+    slot = i;
+    break;
+  }
+  WS_BUFFERS_EXIT;
+  if (slot < 0) {
+    delete buffer;
+    return nullptr;
+  }
+  return buffer;
+}
+
+static int8_t wsClientSlot(uint32_t id)
+{
+  for (uint8_t i = 0; i < WS_STATE_CLIENTS; i++) if (wsClients[i].id == id) return i;
+  return -1;
+}
+
+//JSON (or MessagePack) message of a WebSocket client, queued by wsEvent() and handled in the main loop
+void handleWsCommand(uint32_t clientId, char* data, size_t len, bool msgPack)
+{
+  bool verboseResponse = false;
+  uint8_t snapshot = 0;
+  { //scope JsonDocument so it releases its buffer
+    #ifdef WLED_USE_DYNAMIC_JSON
+    DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+    #else
+    if (!requestJSONBufferLock(11)) return;
+    #endif
+
+    DeserializationError error = deserializeCommand(doc, data, len, msgPack);
+    JsonObject root = doc.as<JsonObject>();
+    if (error || root.isNull()) {
+      releaseJSONBufferLock();
+      return;
+    }
+    if (root["v"] && root.size() == 1) {
+      //if the received value is just "{"v":true}", send only to this client
+      verboseResponse = true;
+    } else if (root.containsKey("lv"))
+    {
+      wsLiveClientId = root["lv"] ? clientId : 0;
+      wsLiveFull = (root["lv"] == 2); //{"lv":2} full resolution delta stream
+      wsLivePrevLeds = 0;
+    } else if (root.containsKey(F("snap")))
+    {
+      snapshot = ((root[F("snap")] | 1) == 2) ? 2 : 1; //1: raw, 2: run-length encoded
+    } else if (root.containsKey(F("delta")) && root.size() == 1)
+    {
+      //{"delta":true}: further state updates only contain what changed, starting with a full one
+      int8_t slot = wsClientSlot(clientId);
+      if (slot >= 0) {
+        wsClients[slot].delta = root[F("delta")];
+        wsClients[slot].resync = true;
+        wsClients[slot].pending = true;
+        wsStatePending = true;
+      }
+    } else {
+      verboseResponse = deserializeState(root);
+      if (!interfaceUpdateCallMode) {
+        //special case, only on playlist load, avoid sending twice in rapid succession
+        if (millis() - lastInterfaceUpdate > 1700) verboseResponse = false;
+      }
+    }
+    releaseJSONBufferLock(); // will clean fileDoc
+  }
+  AsyncWebSocketClient * client = ws.client(clientId);
+  if (!client) return; //disconnected meanwhile
+  if (snapshot) {
+    sendLiveSnapshotWs(client, snapshot == 2);
+    return;
+  }
+  //update if it takes longer than 300ms until next "broadcast"
+  if (verboseResponse && (millis() - lastInterfaceUpdate < 1700 || !interfaceUpdateCallMode)) sendDataWs(client, msgPack);
+}
 
 void wsEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsEventType type, void * arg, uint8_t *data, size_t len)
 {
   if(type == WS_EVT_CONNECT){
-    //client connected
-    sendDataWs(client);
+    //client connected, full state is sent from the main loop (see sendStateUpdates())
+    int8_t slot = wsClientSlot(0);
+    if (slot >= 0) {
+      wsClients[slot].delta = false;
+      wsClients[slot].pending = true;
+      wsClients[slot].resync = true;
+      wsClients[slot].id = client->id(); //last, the loop skips free slots
+      wsStatePending = true;
+    }
   } else if(type == WS_EVT_DISCONNECT){
     //client disconnected
     if (client->id() == wsLiveClientId) wsLiveClientId = 0;
+    int8_t slot = wsClientSlot(client->id());
+    if (slot >= 0) wsClients[slot].id = 0;
   } else if(type == WS_EVT_DATA){
     //data packet
     AwsFrameInfo * info = (AwsFrameInfo*)arg;
@@ -32,37 +201,26 @@ void wsEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsEventTyp
           client->text(F("pong"));
           return;
         }
-        bool verboseResponse = false;
-        { //scope JsonDocument so it releases its buffer
-          #ifdef WLED_USE_DYNAMIC_JSON
-          DynamicJsonDocument doc(JSON_BUFFER_SIZE);
-          #else
-          if (!requestJSONBufferLock(11)) return;
-          #endif
-
-          DeserializationError error = deserializeJson(doc, data, len);
-          JsonObject root = doc.as<JsonObject>();
-          if (error || root.isNull()) {
-            releaseJSONBufferLock();
-            return;
-          }
-          if (root["v"] && root.size() == 1) {
-            //if the received value is just "{"v":true}", send only to this client
-            verboseResponse = true;
-          } else if (root.containsKey("lv"))
-          {
-            wsLiveClientId = root["lv"] ? client->id() : 0;
-          } else {
-            verboseResponse = deserializeState(root);
-            if (!interfaceUpdateCallMode) {
-              //special case, only on playlist load, avoid sending twice in rapid succession
-              if (millis() - lastInterfaceUpdate > 1700) verboseResponse = false;
-            }
-          }
-          releaseJSONBufferLock(); // will clean fileDoc
-        }
-        //update if it takes longer than 300ms until next "broadcast"
-        if (verboseResponse && (millis() - lastInterfaceUpdate < 1700 || !interfaceUpdateCallMode)) sendDataWs(client);
+        //applied by the main loop, see handleWsCommand()
+        queueJsonCommand((const char*)data, len, JSON_CMD_WS, client->id());
+      } else if (info->opcode == WS_BINARY && len > 0 && IS_MSGPACK_MAP(data[0]))
+      {
+        //MessagePack state command, same as JSON text
+        queueJsonCommand((const char*)data, len, JSON_CMD_WS | JSON_CMD_MSGPACK, client->id());
+      } else if (info->opcode == WS_BINARY)
+      {
+        //realtime pixel data in the UDP realtime format (e.g. DNRGB: 4, timeout, start hi, start lo, RGB...)
+        if (!receiveDirect || len < 2 || data[0] == 0 || data[0] > 5) return;
+        uint8_t next = (wsRtHead +1) % WS_RT_SLOTS;
+        if (next == wsRtTail || ESP.getFreeHeap() < len + MIN_HEAP_SIZE) return; //main loop is behind, dropped
+        byte* copy = (byte*)malloc(len);
+        if (!copy) return;
+        memcpy(copy, data, len);
+        wsRtQueue[wsRtHead].data   = copy;
+        wsRtQueue[wsRtHead].len    = len;
+        wsRtQueue[wsRtHead].client = client->id();
+        wsRtQueue[wsRtHead].ip     = client->remoteIP();
+        wsRtHead = next;
       }
     } else {
       //message is comprised of multiple frames or the frame is split into multiple packets
@@ -77,9 +235,7 @@ void wsEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsEventTyp
 
       if((info->index + len) == info->len){
         if(info->final){
-          if(info->message_opcode == WS_TEXT) {
-            client->text(F("{\"error\":9}")); //we do not handle split packets right now
-          }
+          client->text(F("{\"error\":9}")); //we do not handle split packets right now
         }
       }
     }
@@ -92,35 +248,139 @@ void wsEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsEventTyp
   }
 }
 
-void sendDataWs(AsyncWebSocketClient * client)
+static AsyncWebSocketMessageBuffer* makeStateBuffer(bool msgPack)
 {
-  if (!ws.count()) return;
   AsyncWebSocketMessageBuffer * buffer;
+  #ifdef WLED_USE_DYNAMIC_JSON
+  DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+  #else
+  if (!requestJSONBufferLock(12)) return nullptr;
+  #endif
+  JsonObject state = doc.createNestedObject("state");
+  serializeState(state);
+  JsonObject info  = doc.createNestedObject("info");
+  serializeInfo(info);
+  size_t len = msgPack ? measureMsgPack(doc) : measureJson(doc);
+  buffer = makeWsBuffer(len);
+  if (buffer) {
+    if (msgPack) serializeMsgPack(doc, buffer->get(), len);
+    else         serializeJson(doc, (char *)buffer->get(), len +1);
+  }
+  releaseJSONBufferLock();
+  return buffer;
+}
 
-  { //scope JsonDocument so it releases its buffer
-    #ifdef WLED_USE_DYNAMIC_JSON
-    DynamicJsonDocument doc(JSON_BUFFER_SIZE);
-    #else
-    if (!requestJSONBufferLock(12)) return;
-    #endif
-    JsonObject state = doc.createNestedObject("state");
-    serializeState(state);
-    JsonObject info  = doc.createNestedObject("info");
-    serializeInfo(info);
-    size_t len = measureJson(doc);
-    buffer = ws.makeBuffer(len);
-    if (!buffer) {
-      releaseJSONBufferLock();
-      return; //out of memory
+static uint32_t segNameHash(const char* name)
+{
+  if (!name) return 0;
+  uint32_t h = 2166136261UL; //FNV-1a
+  while (*name) h = (h ^ (byte)*name++) * 16777619UL;
+  return h;
+}
+
+//differs() does not compare the CCT and the name, which are part of the serialized segment as well
+static inline bool segmentChanged(uint8_t s)
+{
+  WS2812FX::Segment& seg = strip.getSegment(s);
+  if (seg.differs(wsSentSegs[s].seg) || seg.cct != wsSentSegs[s].seg.cct) return true;
+  return segNameHash(seg.name) != wsSentSegs[s].nameHash;
+}
+
+//state without info, segments only if they changed since the last delta broadcast (removed ones as {"id":n,"stop":0})
+static AsyncWebSocketMessageBuffer* makeDeltaBuffer()
+{
+  AsyncWebSocketMessageBuffer * buffer;
+  #ifdef WLED_USE_DYNAMIC_JSON
+  DynamicJsonDocument doc(JSON_BUFFER_SIZE);
+  #else
+  if (!requestJSONBufferLock(21)) return nullptr;
+  #endif
+  JsonObject state = doc.createNestedObject("state");
+  serializeState(state, false, true, true, false);
+  JsonArray segs = state.createNestedArray("seg");
+  for (byte s = 0; s < strip.getMaxSegments(); s++) {
+    WS2812FX::Segment &sg = strip.getSegment(s);
+    if (!segmentChanged(s)) continue;
+    JsonObject seg0 = segs.createNestedObject();
+    if (sg.isActive()) {
+      serializeSegment(seg0, sg, s);
+    } else {
+      seg0["id"] = s;
+      seg0["stop"] = 0;
     }
+  }
+  doc["delta"] = true;
+  size_t len = measureJson(doc);
+  buffer = makeWsBuffer(len);
+  if (buffer) {
     serializeJson(doc, (char *)buffer->get(), len +1);
-    releaseJSONBufferLock();
-  } 
-  if (client) {
+    for (byte s = 0; s < strip.getMaxSegments(); s++) {
+      wsSentSegs[s].seg = strip.getSegment(s);
+      wsSentSegs[s].seg.name = nullptr;
+      wsSentSegs[s].nameHash = segNameHash(strip.getSegment(s).name);
+    }
+  }
+  releaseJSONBufferLock();
+  return buffer;
+}
+
+//full state and info to one client (optionally as MessagePack) right away,
+//or schedule an update of all clients (sent by handleWs(), see sendStateUpdates())
+void sendDataWs(AsyncWebSocketClient * client, bool msgPack)
+{
+  if (!ws.count()) return;
+  if (!client) {
+    for (uint8_t i = 0; i < WS_STATE_CLIENTS; i++) wsClients[i].pending = true;
+    wsStatePending = true;
+    return;
+  }
+  AsyncWebSocketMessageBuffer * buffer = makeStateBuffer(msgPack);
+  if (!buffer) return; //out of memory or JSON buffer busy
+  if (msgPack) client->binary(buffer);
+  else         client->text(buffer);
+  buffer->unlock();
+}
+
+//send the current state to all clients with a pending update, at most once per WS_UPDATE_INTERVAL.
+//Clients that are still busy receiving keep their update pending and get the then current state later,
+//so intermediate states are dropped instead of piling up. A delta client that missed one gets the full state.
+static void sendStateUpdates()
+{
+  if (!wsStatePending || millis() - wsLastStateTime < WS_UPDATE_INTERVAL) return;
+  wsLastStateTime = millis();
+  wsStatePending = false;
+
+  AsyncWebSocketMessageBuffer * full = nullptr;
+  AsyncWebSocketMessageBuffer * delta = nullptr;
+  for (uint8_t i = 0; i < WS_STATE_CLIENTS; i++) {
+    if (!wsClients[i].id || !wsClients[i].pending) continue;
+    AsyncWebSocketClient * client = ws.client(wsClients[i].id);
+    if (!client) {
+      wsClients[i].id = 0;
+      continue;
+    }
+    if (client->queueLength() > 0) {
+      if (wsClients[i].delta) wsClients[i].resync = true;
+      wsStatePending = true;
+      continue;
+    }
+    bool sendDelta = wsClients[i].delta && !wsClients[i].resync;
+    AsyncWebSocketMessageBuffer * buffer = sendDelta ? delta : full;
+    if (!buffer) {
+      buffer = sendDelta ? makeDeltaBuffer() : makeStateBuffer(false);
+      if (!buffer) { //out of memory or JSON buffer busy, retry next interval
+        wsStatePending = true;
+        continue;
+      }
+      if (sendDelta) delta = buffer;
+      else           full  = buffer;
+    }
     client->text(buffer);
-  } else {
-    ws.textAll(buffer);
+    wsClients[i].pending = false;
+    wsClients[i].resync = false;
   }
+  if (full)  full->unlock(); //kept locked for the other clients
+  if (delta) delta->unlock();
 }
 
 #define MAX_LIVE_LEDS_WS 256
@@ -132,7 +392,7 @@ bool sendLiveLedsWs(uint32_t wsClient)
 
   uint16_t used = strip.getLengthTotal();
   uint16_t n = ((used -1)/MAX_LIVE_LEDS_WS) +1; //only serve every n'th LED if count over MAX_LIVE_LEDS_WS
-  AsyncWebSocketMessageBuffer * wsBuf = ws.makeBuffer(2 + (used*3)/n);
+  AsyncWebSocketMessageBuffer * wsBuf = makeWsBuffer(2 + (used*3)/n);
   if (!wsBuf) return false; //out of memory
   uint8_t* buffer = wsBuf->get();
   buffer[0] = 'L';
@@ -148,17 +408,153 @@ bool sendLiveLedsWs(uint32_t wsClient)
   }
 
   wsc->binary(wsBuf);
+  wsBuf->unlock();
   return true;
 }
 
+//spans of LEDs in cur that changed since wsLivePrev, written to buf (may be nullptr to only get the length)
+//as snapshot header and [start hi, start lo, length -1, RGB...] spans. Returns LIVE_SNAPSHOT_HEADER if
+//nothing changed and 0 if the delta would not be smaller than a keyframe of max bytes
+static uint32_t writeLiveDelta(byte* buf, const byte* cur, uint16_t used, uint32_t max)
+{
+  uint32_t len = LIVE_SNAPSHOT_HEADER;
+  uint16_t i = 0;
+  while (i < used) {
+    if (!memcmp(cur + i*3, wsLivePrev + i*3, 3)) { i++; continue; }
+    //extend span over changed LEDs, bridging single unchanged ones (a span header costs as much as one LED)
+    uint16_t start = i, last = i;
+    for (uint16_t j = i +1; j < used && j - start < 256; j++) {
+      if (memcmp(cur + j*3, wsLivePrev + j*3, 3)) last = j;
+      else if (j - last > 1) break;
+    }
+    uint16_t n = last - start +1;
+    if (len + 3 + n*3 >= max) return 0; //delta larger than a keyframe
+    if (buf) {
+      buf[len]   = start >> 8;
+      buf[len+1] = start & 0xFF;
+      buf[len+2] = n -1;
+      memcpy(buf + len +3, cur + start*3, n*3);
+    }
+    len += 3 + n*3;
+    i = last +1;
+  }
+  if (buf) {
+    buf[0] = 'L';
+    buf[1] = LIVE_SNAPSHOT_VERSION;
+    buf[2] = LIVE_SNAPSHOT_DELTA;
+    buf[3] = used >> 8;
+    buf[4] = used & 0xFF;
+  }
+  return len;
+}
+
+//full resolution live stream: a keyframe (snapshot) first, then only the spans that changed.
+//the rate adapts to how fast the client drains its send queue
+bool sendLiveFrameWs(uint32_t wsClient)
+{
+  AsyncWebSocketClient * wsc = ws.client(wsClient);
+  if (!wsc) return false;
+  if (wsc->queueLength() > 0) { //client is behind, slow down
+    wsLiveInterval = min(wsLiveInterval*2, WS_LIVE_INTERVAL_MAX);
+    return false;
+  }
+  if (wsLiveInterval > WS_LIVE_INTERVAL) wsLiveInterval -= (wsLiveInterval - WS_LIVE_INTERVAL +7) >> 3;
+
+  uint16_t used = strip.getLengthTotal();
+  uint32_t raw = used*3;
+  byte* cur = (byte*)malloc(raw);
+  if (!cur) return false;
+  bool rle = false;
+  writeLiveLeds(cur, raw, rle);
+
+  //measure first, so the message is written straight into its send buffer
+  uint32_t len = 0;
+  bool delta = wsLivePrev && wsLivePrevLeds == used && millis() - wsLastKeyframe < WS_LIVE_KEYFRAME;
+  if (delta) {
+    len = writeLiveDelta(nullptr, cur, used, LIVE_SNAPSHOT_HEADER + raw);
+    if (len == LIVE_SNAPSHOT_HEADER) { //nothing changed
+      free(cur);
+      return true;
+    }
+    delta = len;
+  }
+  rle = true;
+  if (!delta) len = liveLedsBinarySize(rle);
+
+  AsyncWebSocketMessageBuffer * wsBuf = makeWsBuffer(len);
+  if (!wsBuf) { //out of memory
+    free(cur);
+    return false;
+  }
+  if (delta) writeLiveDelta(wsBuf->get(), cur, used, LIVE_SNAPSHOT_HEADER + raw);
+  else {
+    serializeLiveLedsBinary(wsBuf->get(), len, rle);
+    wsLastKeyframe = millis();
+  }
+  wsc->binary(wsBuf);
+  wsBuf->unlock();
+  free(wsLivePrev);
+  wsLivePrev = cur;
+  wsLivePrevLeds = used;
+  return true;
+}
+
+//full resolution binary LED snapshot, see serializeLiveLedsBinary()
+bool sendLiveSnapshotWs(AsyncWebSocketClient * client, bool rle)
+{
+  uint32_t size = liveLedsBinarySize(rle);
+  AsyncWebSocketMessageBuffer * wsBuf = makeWsBuffer(size);
+  if (!wsBuf) return false; //out of memory
+  bool sent = serializeLiveLedsBinary(wsBuf->get(), size, rle) == size; //LEDs may have changed since measuring
+  if (sent) client->binary(wsBuf);
+  wsBuf->unlock();
+  return sent;
+}
+
 void handleWs()
 {
-  if (millis() - wsLastLiveTime > WS_LIVE_INTERVAL)
+  //binary realtime frames of one loop are shown together, the sender gets a single 'A' byte back
+  //once the frame is shown and its send queue is empty, so it can pace itself to the display
+  while (wsRtTail != wsRtHead) {
+    realtimeIP = wsRtQueue[wsRtTail].ip;
+    realtimeStatsPacket(REALTIME_MODE_WS, realtimeIP);
+    if (handleRealtimeDirect(wsRtQueue[wsRtTail].data, wsRtQueue[wsRtTail].len, REALTIME_MODE_WS)) {
+      wsRealtimeClientId = wsRtQueue[wsRtTail].client;
+      wsShowPending = true;
+    }
+    free(wsRtQueue[wsRtTail].data);
+    wsRtTail = (wsRtTail +1) % WS_RT_SLOTS;
+  }
+  if (wsShowPending) {
+    wsShowPending = false;
+    strip.show();
+    realtimeStatsShow();
+    wsAckPending = true;
+  }
+  sendStateUpdates();
+  releaseWsBuffers();
+  if (wsAckPending) {
+    AsyncWebSocketClient * wsc = ws.client(wsRealtimeClientId);
+    if (!wsc) wsAckPending = false;
+    else if (wsc->queueLength() == 0) {
+      wsc->binary("A", 1);
+      wsAckPending = false;
+    }
+  }
+
+  if (millis() - wsLastLiveTime > (wsLiveFull ? wsLiveInterval : WS_LIVE_INTERVAL))
   {
     ws.cleanupClients();
     bool success = true;
-    if (wsLiveClientId)
+    if (wsLiveClientId && wsLiveFull)
+      success = sendLiveFrameWs(wsLiveClientId);
+    else if (wsLiveClientId)
       success = sendLiveLedsWs(wsLiveClientId);
+    if (wsLivePrev && !(wsLiveClientId && wsLiveFull)) { //stream ended
+      free(wsLivePrev);
+      wsLivePrev = nullptr;
+      wsLiveInterval = WS_LIVE_INTERVAL;
+    }
     wsLastLiveTime = millis();
     if (!success) wsLastLiveTime -= 20; //try again in 20ms if failed due to non-empty WS queue
   }
@@ -166,5 +562,6 @@ void handleWs()
 
 #else
 void handleWs() {}
-void sendDataWs(AsyncWebSocketClient * client) {}
+void handleWsCommand(uint32_t clientId, char* data, size_t len, bool msgPack) {}
+void sendDataWs(AsyncWebSocketClient * client, bool msgPack) {}
 #endif
\ No newline at end of file
@@ -324,13 +324,18 @@ void getSettingsJS(byte subPage, char* dest)
     #ifdef WLED_USE_DYNAMIC_JSON
     DynamicJsonDocument doc(3072);
     #else
-    if (!requestJSONBufferLock(6)) return;
+    //settings pages are served from the async web server, which can not wait for the JSON buffer
+    DynamicJsonDocument* umDoc = requestJSONBufferLock(6) ? nullptr : new DynamicJsonDocument(3072);
+    JsonDocument& doc = umDoc ? *(JsonDocument*)umDoc : ::doc;
     #endif
 
     JsonObject mods = doc.createNestedObject(F("um"));
     usermods.addToConfig(mods);
     if (!mods.isNull()) fillUMPins(mods);
-    releaseJSONBufferLock();
+    #ifndef WLED_USE_DYNAMIC_JSON
+    if (umDoc) delete umDoc;
+    else releaseJSONBufferLock();
+    #endif
     }
 
     #ifdef WLED_ENABLE_DMX